@@ -1,86 +1,942 @@
 #include "customfilterproxymodel.h"
+#include "filterquery.h"
 #include "gstreamerlogmodel.h"
+#include "gstreamerlogstore.h"
+#include "roaringbitmap.h"
+#include "rowbitmap.h"
 #include "timestamp.h"
 
-#include <QtCore/QMetaProperty>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFuture>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QHash>
+#include <QtCore/QSettings>
+#include <QtCore/QTimer>
 #include <QtGui/QColor>
-#include <QtGui/QGuiApplication>
 #include <QtGui/QFont>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+
 class CustomFilterProxyModel::Private
 {
 public:
     Private(CustomFilterProxyModel *parent);
-    QModelIndex findNearestTimestamp(int minRow, int maxRow, const Timestamp &timestamp) const;
+    QModelIndex findNearestTimestamp(Timestamp timestamp) const;
+
+    void start();
+    void extend();
+    void run();
+    void cancel();
+    void finish();
+    void apply(RowBitmap &&shown, bool isFiltered);
+    bool isMatched(qsizetype row, int column);
+    QList<FilterQuery::Span> matchSpans(qsizetype row, int column);
+
+    void find(const QString &text, const QList<int> &columns);
+    void cancelFind();
+    void finishFind();
+    // the source is held back while a filter or a find reads the store
+    void suspend();
+
+    void rowsAboutToBeInserted(int first, int last);
+    void rowsInserted(int first, int last);
+    void rowsAboutToBeRemoved(int first, int last);
+    void rowsRemoved(int first, int last);
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles);
 
 private:
     CustomFilterProxyModel *q;
 public:
+    GStreamerLogModel *model = nullptr;
     QString filter;
-    mutable int progress = -1;
+    FilterQuery query;
+    int progress = -1;
+    bool filtering = false;
+
+    // source rows the proxy shows, all of them unless filtered, and the
+    // query they are for, empty if they are not all for the same one
+    bool filtered = false;
+    RowBitmap rows;
+    FilterQuery shown;
+    // source rows that came in while filtered and wait for extend(), clear in
+    // rows until then; as many as rows, or none if nothing waits
+    RowBitmap pending;
+    bool extendQueued = false;
+    // whether results has the rows as they are now
+    bool remembered = true;
+    // FilterQuery::mask() of the shown rows by store row, UnknownMask until
+    // the row was looked at; rows the run accepts get theirs in masking
+    static constexpr quint16 UnknownMask = 0x8000;
+    QList<quint16> masks;
+    QList<quint16> masking;
+    // FilterQuery::spans() of the matched cells painted so far, by store row
+    // and column, for the query; a screenful is looked up again on every
+    // scroll step, so this only needs to hold a few of them
+    static constexpr qsizetype MaxSpans = 16384;
+    QHash<quint64, QList<FilterQuery::Span>> spans;
+
+    // Results of recent queries by FilterQuery::key(), least recently used
+    // first, compressed and within the budget set in the preferences. A query
+    // that only adds clauses starts from the narrowest of them, so the latest
+    // result is kept whatever the budget. Rows the source inserts are clear
+    // in rows and set in unknown, the run that looks a result up again
+    // evaluates the query for them; both always cover every source row.
+    struct Result {
+        QString key;
+        QSet<QString> clauses;
+        RoaringBitmap rows;
+        RoaringBitmap unknown;
+    };
+    QList<Result> results;
+    qsizetype lookups = 0;
+    qsizetype hits = 0;
+    static qint64 cacheSize();
+    void remember(const FilterQuery &query, const RowBitmap &rows, const RowBitmap &unknown);
+    void evict();
+    void clearResults();
+
+    // proxy rows of the source rows being removed, empty if none are shown
+    int removedFirst = 0;
+    int removedLast = -1;
+
+    // the run in flight, over source rows [first, last) within one block of
+    // RangeSize rows each
+    struct Range {
+        qsizetype first;
+        qsizetype last;
+    };
+    QList<Range> ranges;
+    // what the run evaluates: the query, or the clauses base has not seen;
+    // the rows of stale are evaluated for the whole query
+    FilterQuery work;
+    QString key;
+    QSet<QString> keys;
+    bool refining = false;
+    RowBitmap base;
+    RowBitmap stale;
+    // a run of extend(), which neither shows progress nor takes the time
+    bool extending = false;
+    // store rows the clauses on posted columns let through, if there were any
+    RowBitmap candidates;
+    RowBitmap accepted;
+    QFuture<void> future;
+    // counts the runs, only the latest one may publish its rows
+    quint64 generation = 0;
+    QElapsedTimer elapsed;
+    qint64 filterTime = -1;
+    bool running = false;
+    // canceled because the source changed, to start over once it did
+    bool restart = false;
+    std::atomic<bool> canceled = false;
+    std::atomic<qsizetype> done = 0;
+    QTimer progressTimer;
+
+    // The find in flight. The ranges of shown rows are searched on the
+    // thread pool, each collecting the proxy rows of its hits, while the
+    // source is suspended. Whatever changes the shown rows cancels it first.
+    struct Hits {
+        qsizetype first;
+        qsizetype last;
+        QList<int> rows;
+        QList<Timestamp> timestamps;
+    };
+    struct Search {
+        QByteArray needle;
+        QList<int> columns;
+        // per string of the symbol columns searched, whether it has needle
+        std::array<QList<bool>, GStreamerLogStore::SymbolCount> strings;
+        // the trigrams fold ASCII, so they let through every row that has needle
+        bool indexed = false;
+        RowBitmap candidates;
+        QList<Hits> ranges;
+
+        bool contains(const GStreamerLogStore &store, qsizetype row) const;
+    } search;
+    QFuture<void> findFuture;
+    // counts the finds, only the latest one may deliver its hits
+    quint64 findGeneration = 0;
+    bool finding = false;
+    std::atomic<bool> findCanceled = false;
 };
 
 CustomFilterProxyModel::Private::Private(CustomFilterProxyModel *parent)
     : q(parent)
-{}
+{
+    progressTimer.setInterval(100);
+    QObject::connect(&progressTimer, &QTimer::timeout, q, [this]() {
+        const auto count = ranges.isEmpty() ? 0 : ranges.last().last - ranges.first().first;
+        q->setProgress(count > 0 ? done.load(std::memory_order_relaxed) * 100 / count : 0);
+    });
+}
+
+// Splits the source rows into word-aligned ranges, so the threads of the pool
+// set bits in words of their own. The query and the store are only read while
+// the run is in flight: the source is suspended, and whatever changes either
+// cancels the run first. A query that only adds clauses to a recent one is
+// evaluated over the rows that one accepted, and only for the added clauses,
+// except for rows that came in after it, which get the whole query. Clauses
+// the posting lists of the store answer are looked up beforehand, so the
+// threads skip the rows those reject without reading them, and the rows of a
+// Timestamp range are found by binary search, so only they are split.
+void CustomFilterProxyModel::Private::start()
+{
+    cancel();
+    spans.clear();
+    if (!model)
+        return;
+    // the rows shown were filtered as they came in, keep them before they go
+    if (filtered && !remembered && !shown.isEmpty())
+        remember(shown, rows, pending);
+    remembered = true;
+    if (query.isEmpty()) {
+        masks.clear();
+        if (filtered) {
+            shown = FilterQuery();
+            apply(RowBitmap(), false);
+        }
+        return;
+    }
+
+    const auto &store = model->store();
+    query.prepare(store);
+    key = query.key();
+    keys = query.keys();
+    // a size of 0 leaves only the latest result, for refining
+    const bool caching = cacheSize() > 0;
+    if (caching)
+        lookups++;
+    const Result *narrowest = nullptr;
+    for (qsizetype i = 0; i < results.count(); i++) {
+        const auto &result = results.at(i);
+        if (caching && result.key == key && result.unknown.count() == 0) {
+            hits++;
+            emit q->cacheHitRateChanged(q->cacheHitRate());
+            auto cached = result.rows.toRowBitmap();
+            results.move(i, results.count() - 1);
+            masks = QList<quint16>(store.count(), UnknownMask);
+            shown = query;
+            apply(std::move(cached), true);
+            return;
+        }
+        if (keys.contains(result.clauses) && (!narrowest || result.clauses.count() > narrowest->clauses.count()))
+            narrowest = &result;
+    }
+    // the same query, only the rows that came in since are evaluated
+    if (caching && narrowest && narrowest->key == key)
+        hits++;
+    if (caching)
+        emit q->cacheHitRateChanged(q->cacheHitRate());
+    refining = narrowest;
+    base = refining ? narrowest->rows.toRowBitmap() : RowBitmap();
+    stale = refining ? narrowest->unknown.toRowBitmap() : RowBitmap();
+    work = refining ? query.without(narrowest->clauses) : query;
+    masking = QList<quint16>(store.count(), UnknownMask);
+    extending = false;
+    q->setFiltering(true);
+    q->setProgress(0);
+    run();
+    progressTimer.start();
+}
+
+// Evaluates the rows that came in while filtered the way start() refines the
+// rows shown, on the pool, and shows those the query accepts. The source
+// stays suspended meanwhile, rows that come in after wait for the next one.
+void CustomFilterProxyModel::Private::extend()
+{
+    extendQueued = false;
+    if (!model || running || !filtered || pending.count() == 0)
+        return;
+    const auto &store = model->store();
+    // new rows may bring new symbols
+    query.prepare(store);
+    key = query.key();
+    keys = query.keys();
+    refining = true;
+    base = rows;
+    stale = std::exchange(pending, RowBitmap());
+    work = FilterQuery();
+    masking = masks;
+    masking.resize(store.count(), UnknownMask);
+    extending = true;
+    run();
+    suspend();
+}
+
+void CustomFilterProxyModel::Private::run()
+{
+    const auto &store = model->store();
+    const qsizetype count = store.order.count();
+    // the rows base accepted pass as they are, and only the stale ones are read
+    const bool keep = refining && work.isEmpty();
+    qsizetype begin = 0;
+    qsizetype end = count;
+    FilterQuery rest;
+    if (work.interval(store, &begin, &end, &rest))
+        work = rest;
+    if (work.lookup(store, &candidates, &rest))
+        work = rest;
+    else
+        candidates = RowBitmap();
+
+    // blocks are word-aligned even where the interval is not
+    constexpr qsizetype RangeSize = 64 * 1024;
+    ranges.clear();
+    for (qsizetype first = begin / RangeSize * RangeSize; first < end; first += RangeSize)
+        ranges.append({ qMax(first, begin), qMin(first + RangeSize, end) });
+    accepted = keep ? std::exchange(base, RowBitmap()) : RowBitmap(count);
+    canceled = false;
+    done = 0;
+    running = true;
+    generation++;
+    elapsed.start();
+
+    const auto words = accepted.data();
+    const auto accepting = base.size() > 0 ? base.constData() : nullptr;
+    const auto unknown = stale.size() > 0 ? stale.constData() : nullptr;
+    const auto posted = candidates.size() > 0 ? candidates.constData() : nullptr;
+    const auto rowMasks = masking.data();
+    future = QtConcurrent::map(ranges, [this, &store, words, accepting, unknown, posted, rowMasks](const Range &range) {
+        auto matches = [&](qsizetype row, const FilterQuery &filter) {
+            const auto storeRow = store.order.at(row);
+            if (posted && !(posted[storeRow >> 6] >> (storeRow & 63) & 1))
+                return false;
+            if (!filter.matches(store, storeRow))
+                return false;
+            // what FontRole shows in bold, while the row is at hand
+            if (rowMasks[storeRow] & UnknownMask)
+                rowMasks[storeRow] = query.mask(store, storeRow);
+            return true;
+        };
+        if (refining) {
+            // only the rows the wider query let through, and those it did not see
+            const auto last = (range.last + 63) >> 6;
+            for (auto word = range.first >> 6; word < last; word++) {
+                if ((word & 15) == 0 && canceled.load(std::memory_order_relaxed))
+                    return;
+                const auto unseen = unknown ? unknown[word] : 0;
+                for (auto bits = (accepting ? accepting[word] : 0) | unseen; bits; bits &= bits - 1) {
+                    const auto bit = std::countr_zero(bits);
+                    const auto row = word * 64 + bit;
+                    if (row >= range.first && row < range.last && matches(row, unseen >> bit & 1 ? query : work))
+                        words[word] |= quint64(1) << bit;
+                }
+            }
+        } else {
+            for (auto row = range.first; row < range.last; row++) {
+                if ((row & 1023) == 0 && canceled.load(std::memory_order_relaxed))
+                    return;
+                if (matches(row, work))
+                    words[row >> 6] |= quint64(1) << (row & 63);
+            }
+        }
+        done.fetch_add(range.last - range.first, std::memory_order_relaxed);
+    });
+    future.then(q, [this, run = generation]() {
+        // a run that was canceled may still report in after the next started
+        if (running && run == generation)
+            finish();
+    });
+}
+
+// Stops the run in flight and waits for the threads to let go of the store.
+// Leaves filtering as it is, the caller either starts again or says so.
+void CustomFilterProxyModel::Private::cancel()
+{
+    if (!running)
+        return;
+    canceled = true;
+    generation++;
+    future.cancel();
+    future.waitForFinished();
+    running = false;
+    if (extending) {
+        // the rows still wait, for the run that comes next
+        extending = false;
+        pending = std::exchange(stale, RowBitmap());
+        QMetaObject::invokeMethod(q, [this]() { suspend(); }, Qt::QueuedConnection);
+    }
+    base = RowBitmap();
+    stale = RowBitmap();
+    candidates = RowBitmap();
+    masking.clear();
+    progressTimer.stop();
+}
+
+void CustomFilterProxyModel::Private::finish()
+{
+    running = false;
+    progressTimer.stop();
+    accepted.update();
+    base = RowBitmap();
+    stale = RowBitmap();
+    candidates = RowBitmap();
+    masks = std::exchange(masking, QList<quint16>());
+    if (extending) {
+        extending = false;
+        const auto count = rows.count();
+        const auto last = count > 0 ? rows.select(count - 1) : -1;
+        if (accepted.count() > count && accepted.rank(last + 1) == count) {
+            // mostly the rows come in after those shown
+            q->beginInsertRows(QModelIndex(), count, accepted.count() - 1);
+            rows = std::exchange(accepted, RowBitmap());
+            q->endInsertRows();
+        } else if (accepted.count() > count) {
+            apply(std::exchange(accepted, RowBitmap()), true);
+        } else {
+            rows = std::exchange(accepted, RowBitmap());
+        }
+        remembered = false;
+        // rows held back come in now
+        suspend();
+        return;
+    }
+    filterTime = elapsed.elapsed();
+    emit q->filterTimeChanged(filterTime);
+    // worth a look at what made it slow
+    if (filterTime > 1000)
+        qWarning().noquote() << "filter" << key << "took" << filterTime << "ms over" << accepted.size() << "rows";
+    remember(query, accepted, RowBitmap());
+    shown = query;
+    apply(std::exchange(accepted, RowBitmap()), true);
+    q->setProgress(100);
+    q->setFiltering(false);
+}
+
+// the budget of results set in the preferences, in bytes
+qint64 CustomFilterProxyModel::Private::cacheSize()
+{
+    QSettings settings;
+    settings.beginGroup("Preferences");
+    return settings.value(QStringLiteral("filterCacheSize"), 64).toLongLong() << 20;
+}
+
+// unknown is empty if the query was evaluated for every row
+void CustomFilterProxyModel::Private::remember(const FilterQuery &query, const RowBitmap &rows, const RowBitmap &unknown)
+{
+    const auto key = query.key();
+    results.removeIf([&](const Result &result) {
+        return result.key == key;
+    });
+    results.append({ key, query.keys(), RoaringBitmap(rows), RoaringBitmap(unknown.size() > 0 ? unknown : RowBitmap(rows.size())) });
+    evict();
+}
+
+void CustomFilterProxyModel::Private::evict()
+{
+    const auto budget = cacheSize();
+    qsizetype bytes = 0;
+    for (const auto &result : std::as_const(results))
+        bytes += result.rows.bytes() + result.unknown.bytes();
+    while (bytes > budget && results.count() > 1) {
+        const auto result = results.takeFirst();
+        bytes -= result.rows.bytes() + result.unknown.bytes();
+    }
+}
+
+void CustomFilterProxyModel::Private::clearResults()
+{
+    results.clear();
+    lookups = 0;
+    hits = 0;
+    emit q->cacheHitRateChanged(q->cacheHitRate());
+}
+
+// Swaps the rows in one layout change, so selections and the current index
+// stay on their source rows where those are still shown.
+void CustomFilterProxyModel::Private::apply(RowBitmap &&shown, bool isFiltered)
+{
+    cancelFind();
+    emit q->layoutAboutToBeChanged();
+    const auto from = q->persistentIndexList();
+    QModelIndexList sources;
+    sources.reserve(from.count());
+    for (const auto &index : from)
+        sources.append(q->mapToSource(index));
+
+    rows = std::move(shown);
+    pending = RowBitmap();
+    filtered = isFiltered;
+
+    QModelIndexList to;
+    to.reserve(sources.count());
+    for (const auto &index : std::as_const(sources))
+        to.append(q->mapFromSource(index));
+    q->changePersistentIndexList(from, to);
+    emit q->layoutChanged();
+}
+
+// whether the query matches column of store row, for a row it accepts
+bool CustomFilterProxyModel::Private::isMatched(qsizetype row, int column)
+{
+    const auto &store = model->store();
+    // the rows shown are still those of the query before
+    if (running && !extending)
+        return query.highlights(store, row, column);
+    if (row >= masks.count())
+        return query.mask(store, row) >> column & 1;
+    auto &mask = masks[row];
+    if (mask & UnknownMask)
+        mask = query.mask(store, row);
+    return mask >> column & 1;
+}
+
+// what the query matches in column of store row, for a row it accepts
+QList<FilterQuery::Span> CustomFilterProxyModel::Private::matchSpans(qsizetype row, int column)
+{
+    const auto key = quint64(row) << 4 | column;
+    auto it = spans.constFind(key);
+    if (it == spans.constEnd()) {
+        if (spans.count() >= MaxSpans)
+            spans.clear();
+        it = spans.insert(key, query.spans(model->store(), row, column));
+    }
+    return it.value();
+}
+
+void CustomFilterProxyModel::Private::rowsAboutToBeInserted(int first, int last)
+{
+    cancelFind();
+    // the store already grew, the run can not go on reading it
+    if (running) {
+        cancel();
+        restart = true;
+    }
+    if (!filtered)
+        q->beginInsertRows(QModelIndex(), first, last);
+}
+
+void CustomFilterProxyModel::Private::rowsInserted(int first, int last)
+{
+    const auto &store = model->store();
+    // also after a reload, when the rows come in filtered one chunk at a time
+    if (filtered || !masks.isEmpty())
+        masks.insert(masks.count(), store.count() - masks.count(), UnknownMask);
+    RowBitmap inserted(last - first + 1);
+    RowBitmap unknown(inserted.size());
+    for (qsizetype row = 0; row < unknown.size(); row++)
+        unknown.setBit(row);
+    unknown.update();
+    if (!filtered) {
+        q->endInsertRows();
+    } else {
+        // shown once extend() evaluated them on the pool
+        if (pending.size() == 0)
+            pending = RowBitmap(rows.size());
+        rows.insert(first, inserted);
+        pending.insert(first, unknown);
+        if (!restart && !extendQueued) {
+            extendQueued = true;
+            QMetaObject::invokeMethod(q, [this]() { extend(); }, Qt::QueuedConnection);
+        }
+    }
+
+    // the results take the rows in too, to be evaluated when looked up
+    for (auto &result : results) {
+        result.rows.insert(first, inserted);
+        result.unknown.insert(first, unknown);
+    }
+    if (!results.isEmpty())
+        evict();
+
+    if (restart) {
+        // the rows are partly for the query before
+        restart = false;
+        shown = FilterQuery();
+        start();
+    } else {
+        remembered = false;
+    }
+}
+
+void CustomFilterProxyModel::Private::rowsAboutToBeRemoved(int first, int last)
+{
+    cancelFind();
+    if (running) {
+        cancel();
+        restart = true;
+    }
+    if (!filtered) {
+        q->beginRemoveRows(QModelIndex(), first, last);
+        return;
+    }
+    removedFirst = rows.rank(first);
+    removedLast = rows.rank(last + 1) - 1;
+    if (removedFirst <= removedLast)
+        q->beginRemoveRows(QModelIndex(), removedFirst, removedLast);
+}
+
+void CustomFilterProxyModel::Private::rowsRemoved(int first, int last)
+{
+    // the store rows that are left may be parsed again
+    spans.clear();
+    if (model->rowCount() > 0) {
+        // a line parsed again, the other rows stay as they are
+        for (auto &result : results) {
+            result.rows.remove(first, last - first + 1);
+            result.unknown.remove(first, last - first + 1);
+        }
+        if (!masks.isEmpty())
+            masks.resize(model->store().count());
+    } else {
+        // the symbols are assigned again when the source is reloaded
+        query = FilterQuery(filter);
+        masks.clear();
+        clearResults();
+        shown = FilterQuery();
+    }
+    if (!filtered) {
+        q->endRemoveRows();
+    } else {
+        rows.remove(first, last - first + 1);
+        if (pending.size() > 0)
+            pending.remove(first, last - first + 1);
+        if (removedFirst <= removedLast)
+            q->endRemoveRows();
+        removedLast = removedFirst - 1;
+    }
+    if (!restart)
+        return;
+    restart = false;
+    if (q->sourceModel()->rowCount() > 0) {
+        start();
+    } else {
+        // nothing left to look at, rows that come in are filtered as they do
+        filtered = !query.isEmpty();
+        q->setFiltering(false);
+    }
+}
+
+void CustomFilterProxyModel::Private::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles)
+{
+    if (!filtered) {
+        emit q->dataChanged(q->index(topLeft.row(), topLeft.column()), q->index(bottomRight.row(), bottomRight.column()), roles);
+        return;
+    }
+    const auto first = rows.rank(topLeft.row());
+    const auto last = rows.rank(bottomRight.row() + 1) - 1;
+    if (first <= last)
+        emit q->dataChanged(q->index(first, topLeft.column()), q->index(last, bottomRight.column()), roles);
+}
 
-QModelIndex CustomFilterProxyModel::Private::findNearestTimestamp(int minRow, int maxRow, const Timestamp &timestamp) const
+// Symbol columns are matched once per string instead of once per row, and a
+// search of the Message column alone is narrowed down with the trigram index.
+void CustomFilterProxyModel::Private::find(const QString &text, const QList<int> &columns)
 {
-    if (minRow == maxRow) {
-        return q->index(minRow, GStreamerLogModel::TimestampColumn);
+    cancelFind();
+    if (text.isEmpty() || !model) {
+        emit q->found(QList<int>(), QList<Timestamp>());
+        return;
+    }
+    const auto &store = model->store();
+    search = Search();
+    search.needle = text.toUtf8();
+    search.columns = columns;
+    if (search.columns.isEmpty()) {
+        for (int column = 0; column < GStreamerLogModel::ColumnCount; column++)
+            search.columns.append(column);
+    }
+    for (const auto column : std::as_const(search.columns)) {
+        const auto symbol = GStreamerLogStore::symbol(column);
+        if (symbol < 0)
+            continue;
+        for (const auto &value : store.strings[symbol].values())
+            search.strings[symbol].append(QByteArrayView(value).contains(search.needle));
+    }
+    search.indexed = search.columns == QList<int>{ GStreamerLogModel::MessageColumn } && search.needle.size() >= 3 && store.trigrams.size() > 0;
+    if (search.indexed) {
+        search.candidates = RowBitmap(store.count());
+        store.trigrams.candidates(search.needle.toLower(), &search.candidates);
     }
-    if (minRow + 1 == maxRow) {
-        const auto minIndex  =q->index(minRow, GStreamerLogModel::TimestampColumn);
-        const auto maxIndex = q->index(maxRow, GStreamerLogModel::TimestampColumn);
-        const auto minTimestamp = Timestamp::fromString(minIndex.data().toString());
-        const auto maxTimestamp = Timestamp::fromString(maxIndex.data().toString());
-        auto former = minTimestamp.secsTo(timestamp);
-        auto latter = timestamp.secsTo(maxTimestamp);
-        if (former == latter) {
-            former = minTimestamp.msecsTo(timestamp);
-            latter = timestamp.msecsTo(maxTimestamp);
+    constexpr qsizetype RangeSize = 64 * 1024;
+    const qsizetype count = model->rowCount();
+    for (qsizetype first = 0; first < count; first += RangeSize)
+        search.ranges.append({ first, qMin(first + RangeSize, count), QList<int>(), QList<Timestamp>() });
+
+    findCanceled = false;
+    finding = true;
+    findGeneration++;
+    suspend();
+    findFuture = QtConcurrent::map(search.ranges, [this, &store](Hits &hits) {
+        auto proxyRow = filtered ? rows.rank(hits.first) : hits.first;
+        for (auto row = hits.first; row < hits.last; row++) {
+            if ((row & 1023) == 0 && findCanceled.load(std::memory_order_relaxed))
+                return;
+            if (filtered && !rows.testBit(row))
+                continue;
+            const auto storeRow = store.order.at(row);
+            if (search.contains(store, storeRow)) {
+                hits.rows.append(proxyRow);
+                hits.timestamps.append(Timestamp::fromNSecs(store.rows.timestamp.at(storeRow)));
+            }
+            proxyRow++;
         }
-        if (former == latter) {
-            former = minTimestamp.usecsTo(timestamp);
-            latter = timestamp.usecsTo(maxTimestamp);
+    });
+    auto watcher = new QFutureWatcher<void>(q);
+    QObject::connect(watcher, &QFutureWatcher<void>::finished, q, [this, watcher, run = findGeneration]() {
+        watcher->deleteLater();
+        // a find that was canceled reports in too
+        if (finding && run == findGeneration)
+            finishFind();
+    });
+    watcher->setFuture(findFuture);
+}
+
+// Stops the find in flight and waits for the threads to let go of the store
+void CustomFilterProxyModel::Private::cancelFind()
+{
+    if (!finding)
+        return;
+    findCanceled = true;
+    findGeneration++;
+    findFuture.cancel();
+    findFuture.waitForFinished();
+    finding = false;
+    search = Search();
+    // the caller is about to change the rows, new ones come in after that
+    QMetaObject::invokeMethod(q, [this]() { suspend(); }, Qt::QueuedConnection);
+}
+
+void CustomFilterProxyModel::Private::finishFind()
+{
+    finding = false;
+    QList<int> hits;
+    QList<Timestamp> timestamps;
+    for (const auto &range : std::as_const(search.ranges)) {
+        hits.append(range.rows);
+        timestamps.append(range.timestamps);
+    }
+    search = Search();
+    emit q->found(hits, timestamps);
+    // rows held back come in now, after the hits were taken
+    suspend();
+}
+
+void CustomFilterProxyModel::Private::suspend()
+{
+    if (model)
+        model->setSuspended(filtering || finding || extending);
+}
+
+bool CustomFilterProxyModel::Private::Search::contains(const GStreamerLogStore &store, qsizetype row) const
+{
+    if (indexed && !candidates.testBit(row))
+        return false;
+    for (const auto column : columns) {
+        const auto symbol = GStreamerLogStore::symbol(column);
+        if (symbol >= 0) {
+            if (strings[symbol].at(store.rows.symbols[symbol].at(row)))
+                return true;
+            continue;
         }
-        if (former == latter) {
-            former = minTimestamp.nsecsTo(timestamp);
-            latter = timestamp.nsecsTo(maxTimestamp);
+        if (column == GStreamerLogModel::PidColumn || column == GStreamerLogModel::LineColumn) {
+            char number[16];
+            const auto value = column == GStreamerLogModel::PidColumn ? store.rows.pid.at(row) : store.rows.line.at(row);
+            const auto end = std::to_chars(number, number + sizeof(number), value).ptr;
+            if (QByteArrayView(number, end - number).contains(needle))
+                return true;
+            continue;
+        }
+        if (store.bytes(row, column).contains(needle))
+            return true;
+    }
+    return false;
+}
+
+// The source rows are in timestamp order, so a lower_bound over them and the
+// shown rows on either side of where it lands give the nearest shown row
+// without mapping every step of the search.
+QModelIndex CustomFilterProxyModel::Private::findNearestTimestamp(Timestamp timestamp) const
+{
+    const auto count = q->rowCount();
+    if (count == 0)
+        return QModelIndex();
+    const auto &store = model->store();
+    auto at = [&](qsizetype row) {
+        return Timestamp::fromNSecs(store.rows.timestamp.at(store.order.at(row)));
+    };
+    // the first source row not before timestamp
+    qsizetype first = 0;
+    qsizetype length = model->rowCount();
+    while (length > 0) {
+        const auto half = length / 2;
+        if (at(first + half) < timestamp) {
+            first += half + 1;
+            length -= half + 1;
+        } else {
+            length = half;
         }
-        return former < latter ? minIndex : maxIndex;
     }
 
-    const int midRow = minRow + (maxRow - minRow) / 2;
-    const auto midIndex = q->index(midRow, GStreamerLogModel::TimestampColumn);
-    const auto midTimestamp = Timestamp::fromString(midIndex.data().toString());
-    const auto comp = timestamp <=> midTimestamp;
-    if (comp < 0)
-        return findNearestTimestamp(minRow, midRow, timestamp);
-    else if (comp > 0)
-        return findNearestTimestamp(midRow, maxRow, timestamp);
-    return midIndex;
+    const auto after = filtered ? rows.rank(first) : first;
+    const auto before = after - 1;
+    auto source = [&](qsizetype row) {
+        return filtered ? rows.select(row) : row;
+    };
+    qsizetype row = after;
+    if (after >= count || (before >= 0 && timestamp - at(source(before)) < at(source(after)) - timestamp))
+        row = before;
+    return q->index(row, GStreamerLogModel::TimestampColumn);
 }
 
 CustomFilterProxyModel::CustomFilterProxyModel(QObject *parent)
-    : QSortFilterProxyModel{parent}
+    : QAbstractProxyModel{parent}
     , d{new Private(this)}
+{}
+
+CustomFilterProxyModel::~CustomFilterProxyModel()
 {
-    connect(this, &CustomFilterProxyModel::filterChanged, this, &CustomFilterProxyModel::invalidate);
+    d->cancelFind();
+    d->cancel();
 }
 
-CustomFilterProxyModel::~CustomFilterProxyModel() = default;
+void CustomFilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    d->cancelFind();
+    d->cancel();
+    setFiltering(false);
+    beginResetModel();
+    if (this->sourceModel())
+        disconnect(this->sourceModel(), nullptr, this, nullptr);
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    d->model = qobject_cast<GStreamerLogModel *>(sourceModel);
+    d->query = FilterQuery(d->filter);
+    d->filtered = false;
+    d->rows.clear();
+    d->pending = RowBitmap();
+    d->shown = FilterQuery();
+    d->clearResults();
+    if (sourceModel) {
+        connect(sourceModel, &QAbstractItemModel::rowsAboutToBeInserted, this, [this](const QModelIndex &, int first, int last) {
+            d->rowsAboutToBeInserted(first, last);
+        });
+        connect(sourceModel, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &, int first, int last) {
+            d->rowsInserted(first, last);
+        });
+        connect(sourceModel, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex &, int first, int last) {
+            d->rowsAboutToBeRemoved(first, last);
+        });
+        connect(sourceModel, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &, int first, int last) {
+            d->rowsRemoved(first, last);
+        });
+        connect(sourceModel, &QAbstractItemModel::dataChanged, this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QList<int> &roles) {
+            d->dataChanged(topLeft, bottomRight, roles);
+        });
+        connect(sourceModel, &QAbstractItemModel::headerDataChanged, this, &CustomFilterProxyModel::headerDataChanged);
+        connect(sourceModel, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+            d->cancelFind();
+            d->cancel();
+            setFiltering(false);
+            beginResetModel();
+        });
+        connect(sourceModel, &QAbstractItemModel::modelReset, this, [this]() {
+            d->query = FilterQuery(d->filter);
+            d->filtered = false;
+            d->rows.clear();
+            d->pending = RowBitmap();
+            d->shown = FilterQuery();
+            d->clearResults();
+            endResetModel();
+            d->start();
+        });
+    }
+    endResetModel();
+    d->start();
+}
+
+QModelIndex CustomFilterProxyModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !sourceModel())
+        return QModelIndex();
+    const int row = d->filtered ? d->rows.select(proxyIndex.row()) : proxyIndex.row();
+    return sourceModel()->index(row, proxyIndex.column());
+}
+
+QModelIndex CustomFilterProxyModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid())
+        return QModelIndex();
+    const auto row = sourceIndex.row();
+    if (!d->filtered)
+        return index(row, sourceIndex.column());
+    if (row >= d->rows.size() || !d->rows.testBit(row))
+        return QModelIndex();
+    return index(d->rows.rank(row), sourceIndex.column());
+}
+
+QModelIndex CustomFilterProxyModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (!hasIndex(row, column, parent))
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex CustomFilterProxyModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+int CustomFilterProxyModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return 0;
+    return d->filtered ? d->rows.count() : sourceModel()->rowCount();
+}
+
+int CustomFilterProxyModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return 0;
+    return sourceModel()->columnCount();
+}
 
 QString CustomFilterProxyModel::filter() const
 {
     return d->filter;
 }
 
+// A filter set while the previous one is still running cancels it.
 void CustomFilterProxyModel::setFilter(const QString &filter)
 {
     if (d->filter == filter) return;
+    d->cancel();
     d->filter = filter;
+    d->query = FilterQuery(filter);
     emit filterChanged(filter);
+    d->start();
+    if (!d->running)
+        setFiltering(false);
+}
+
+bool CustomFilterProxyModel::isFiltering() const
+{
+    return d->filtering;
+}
+
+// The source is held back while filtering, so the store does not change
+// underneath the threads, see Private::suspend().
+void CustomFilterProxyModel::setFiltering(bool filtering)
+{
+    if (d->filtering == filtering) return;
+    d->filtering = filtering;
+    d->suspend();
+    emit filteringChanged(filtering);
+}
+
+int CustomFilterProxyModel::cacheHitRate() const
+{
+    return d->lookups > 0 ? d->hits * 100 / d->lookups : -1;
+}
+
+qint64 CustomFilterProxyModel::filterTime() const
+{
+    return d->filterTime;
 }
 
 int CustomFilterProxyModel::progress() const
@@ -88,21 +944,20 @@ int CustomFilterProxyModel::progress() const
     return d->progress;
 }
 
-void CustomFilterProxyModel::setProgress(int progress) const
+void CustomFilterProxyModel::setProgress(int progress)
 {
     if (d->progress == progress) return;
     d->progress = progress;
-    auto that = const_cast<CustomFilterProxyModel *>(this);
-    emit that->progressChanged(progress);
+    emit progressChanged(progress);
 }
 
 QVariant CustomFilterProxyModel::data(const QModelIndex &index, int role) const
 {
-    QVariant ret = QSortFilterProxyModel::data(index, role);
+    QVariant ret = QAbstractProxyModel::data(index, role);
     if (index.column() == GStreamerLogModel::TimestampColumn) {
         auto hasGap = [&](int a, int b) {
-            const auto previousTimestamp = Timestamp::fromString(index.siblingAtRow(a).data().toString());
-            const auto currentTimestamp = Timestamp::fromString(index.siblingAtRow(b).data().toString());
+            const auto previousTimestamp = index.siblingAtRow(a).data(GStreamerLogModel::TimestampRole).value<Timestamp>();
+            const auto currentTimestamp = index.siblingAtRow(b).data(GStreamerLogModel::TimestampRole).value<Timestamp>();
             return previousTimestamp.secsTo(currentTimestamp) > 0;
         };
         switch (role) {
@@ -134,103 +989,22 @@ QVariant CustomFilterProxyModel::data(const QModelIndex &index, int role) const
             break;
         }
     }
-    if (role == Qt::FontRole) {
-        if (!d->filter.isEmpty()) {
-            static const auto mo = &GStreamerLogLine::staticMetaObject;
-            const auto property = mo->property(index.column());
-            const auto filters = d->filter.split(QLatin1Char(' '), Qt::SkipEmptyParts);
-
-            QVariant value = index.data(Qt::DisplayRole);
-            bool matched = false;
-            for (const auto &filter : filters) {
-                auto keyword = filter;
-                if (filter.contains(':')) {
-                    const auto columnName = filter.section(':', 0, 0);
-                    if (columnName == property.name()) {
-                        keyword = filter.section(':', 1);
-                    } else {
-                        continue;
-                    }
-                } else if (index.column() != GStreamerLogModel::MessageColumn) {
-                    continue;
-                }
-
-                switch (property.typeId()) {
-                case QMetaType::QString: {
-                    if (value.toString().contains(keyword, Qt::CaseInsensitive))
-                        matched = true;
-                    break; }
-                case QMetaType::Int: {
-                    if (value.toInt() == keyword.toInt())
-                        matched = true;
-                    break; }
-                default:
-                    break;
-                }
-                if (matched)
-                    break;
-            }
-
-            if (matched) {
+    if ((role == Qt::FontRole || role == MatchSpansRole) && !d->query.isEmpty() && d->model) {
+        const auto &store = d->model->store();
+        const auto row = store.order.at(mapToSource(index).row());
+        if (d->isMatched(row, index.column())) {
+            if (role == Qt::FontRole) {
                 QFont font = ret.value<QFont>();
                 font.setBold(true);
                 ret = QVariant::fromValue(font);
+            } else {
+                ret = QVariant::fromValue(d->matchSpans(row, index.column()));
             }
         }
     }
     return ret;
 }
 
-bool CustomFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
-{
-    static int rowCount = 1;
-    if (source_row == 0)
-        rowCount = sourceModel()->rowCount() - 1;
-    setProgress(source_row * 100 / rowCount);
-
-    if (!d->filter.isEmpty()) {
-        static const auto mo = &GStreamerLogLine::staticMetaObject;
-        static const auto properties = mo->propertyCount();
-        static QHash<QString, int> name2column;
-        if (name2column.isEmpty()) {
-            for (int i = 0; i < properties; ++i) {
-                const auto property = mo->property(i);
-                name2column.insert(property.name(), i);
-            }
-        }
-        auto filters = d->filter.split(' ', Qt::SkipEmptyParts);
-        for (auto i = filters.length() - 1; i >= 0; i--) {
-            QString filter = filters.at(i);
-            int column = GStreamerLogModel::MessageColumn;
-            QString keyword = filter;
-            if (filter.contains(':')) {
-                const auto columnName = filter.section(':', 0, 0);
-                if (name2column.contains(columnName)) {
-                    column = name2column.value(columnName);
-                    keyword = filter.section(':', 1);
-                }
-            }
-            const auto value = sourceModel()->index(source_row, column, source_parent).data();
-            const auto property = mo->property(column);
-            switch (property.typeId()) {
-            case QMetaType::QString:
-                if (value.toString().contains(keyword, Qt::CaseInsensitive))
-                    filters.removeAt(i);
-                break;
-            case QMetaType::Int:
-                if (value.toInt() == keyword.toInt())
-                    filters.removeAt(i);
-                break;
-            default:
-                qWarning() << property.typeId() << "not supported";
-                break;
-            }
-        }
-        if (!filters.isEmpty()) return false;
-    }
-    return true;
-}
-
 QModelIndexList CustomFilterProxyModel::match(const QModelIndex &start, int role, const QVariant &value, int hits, Qt::MatchFlags flags) const
 {
     QModelIndexList ret;
@@ -238,9 +1012,7 @@ QModelIndexList CustomFilterProxyModel::match(const QModelIndex &start, int role
     bool backword = flags & Qt::MatchRecursive; // abuse recursive flag for backwards search
     bool timestampOnly = flags & Qt::MatchStartsWith; // abusing this flag
     if (timestampOnly) {
-        const auto count = rowCount();
-        if (count == 0) return ret;
-        const auto index = d->findNearestTimestamp(0, count - 1, value.value<Timestamp>());
+        const auto index = d->findNearestTimestamp(value.value<Timestamp>());
         if (index.isValid())
             ret << index;
         return ret;
@@ -292,3 +1064,44 @@ QModelIndexList CustomFilterProxyModel::match(const QModelIndex &start, int role
 
     return ret;
 }
+
+void CustomFilterProxyModel::findAll(const QString &text, const QList<int> &columns)
+{
+    d->find(text, columns);
+}
+
+void CustomFilterProxyModel::cancelFind()
+{
+    d->cancelFind();
+}
+
+bool CustomFilterProxyModel::isFinding() const
+{
+    return d->finding;
+}
+
+QList<qsizetype> CustomFilterProxyModel::histogram(Timestamp first, Timestamp last, int buckets) const
+{
+    QList<qsizetype> ret(qMax(buckets, 0), 0);
+    if (!d->model || ret.isEmpty())
+        return ret;
+    const auto &store = d->model->store();
+    const auto &order = store.order;
+    const auto end = order.cbegin() + d->model->rowCount();
+    // the proxy rows before the first source row at or after nsecs
+    auto bound = [&](qint64 nsecs) {
+        const qsizetype row = std::partition_point(order.cbegin(), end, [&](quint32 row) {
+            return store.rows.timestamp.at(row) < nsecs;
+        }) - order.cbegin();
+        return d->filtered ? d->rows.rank(row) : row;
+    };
+    const qreal span = first.nsecsTo(last);
+    auto previous = bound(first.toNSecs());
+    for (int i = 0; i < buckets; i++) {
+        // the last bucket takes last in
+        const auto next = i + 1 < buckets ? bound(first.toNSecs() + qint64(span * (i + 1) / buckets)) : bound(last.toNSecs() + 1);
+        ret[i] = next - previous;
+        previous = next;
+    }
+    return ret;
+}
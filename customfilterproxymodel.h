@@ -1,37 +1,86 @@
 #ifndef CUSTOMFILTERPROXYMODEL_H
 #define CUSTOMFILTERPROXYMODEL_H
 
-#include <QtCore/QSortFilterProxyModel>
+#include "timestamp.h"
+
+#include <QtCore/QAbstractProxyModel>
 
 using QIntList = QList<int>;
 
-class CustomFilterProxyModel : public QSortFilterProxyModel
+// Shows the rows of a GStreamerLogModel that match filter. The filter is
+// evaluated on the thread pool into a bitmap of accepted source rows, which
+// replaces the current one in a single layout change once it is complete;
+// until then the previous rows stay visible. Each run has a generation, a
+// new filter aborts the run before it and only the latest run publishes.
+// Rows the source inserts later are filtered on the thread pool too, and
+// shown once they are.
+class CustomFilterProxyModel : public QAbstractProxyModel
 {
     Q_OBJECT
     Q_PROPERTY(QString filter READ filter WRITE setFilter NOTIFY filterChanged FINAL)
+    Q_PROPERTY(bool filtering READ isFiltering NOTIFY filteringChanged FINAL)
     Q_PROPERTY(int progress READ progress NOTIFY progressChanged FINAL)
+    // percentage of filters that were shown from the cache, -1 before the
+    // first one looked up in it
+    Q_PROPERTY(int cacheHitRate READ cacheHitRate NOTIFY cacheHitRateChanged FINAL)
+    // milliseconds the last run took, -1 before the first
+    Q_PROPERTY(qint64 filterTime READ filterTime NOTIFY filterTimeChanged FINAL)
 public:
+    enum Role {
+        // QList<FilterQuery::Span> of what the filter matches in the text,
+        // after the roles of GStreamerLogModel
+        MatchSpansRole = Qt::UserRole + 2,
+    };
+
     explicit CustomFilterProxyModel(QObject *parent = nullptr);
     ~CustomFilterProxyModel() override;
 
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const override;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
     QModelIndexList match(const QModelIndex &start, int role, const QVariant &value, int hits, Qt::MatchFlags flags) const override;
+    // Looks for the rows where any of columns, all of them if empty, contains
+    // text case-sensitively as it is displayed, and emits found() with them.
+    // The shown rows are split across the thread pool and read straight from
+    // the store, which is held back until then. A new find, cancelFind() or
+    // anything that changes the shown rows cancels the one in flight.
+    void findAll(const QString &text, const QList<int> &columns = QList<int>());
+    void cancelFind();
+    bool isFinding() const;
+    // Rows per bucket of equal time from first to last, both included. The
+    // source rows are in timestamp order, so each bucket costs a binary search.
+    QList<qsizetype> histogram(Timestamp first, Timestamp last, int buckets) const;
 
     QString filter() const;
+    bool isFiltering() const;
     int progress() const;
+    int cacheHitRate() const;
+    qint64 filterTime() const;
 
 public slots:
     void setFilter(const QString &filter);
 
 private slots:
-    void setProgress(int progress) const;
+    void setFiltering(bool filtering);
+    void setProgress(int progress);
 
 signals:
     void filterChanged(const QString &filter);
+    void filteringChanged(bool filtering);
     void progressChanged(int progress);
+    void cacheHitRateChanged(int cacheHitRate);
+    void filterTimeChanged(qint64 filterTime);
+    // the rows findAll() found, ascending, and the timestamp of each
+    void found(const QList<int> &rows, const QList<Timestamp> &timestamps);
 
 protected:
     QVariant data(const QModelIndex &index, int role) const override;
-    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
 
 private:
     class Private;
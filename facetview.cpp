@@ -0,0 +1,126 @@
+#include "facetview.h"
+#include "gstreamerlogmodel.h"
+#include "gstreamerlogstore.h"
+
+#include <QtCore/QTimer>
+
+#include <QtWidgets/QHeaderView>
+
+#include <algorithm>
+
+class FacetView::Private
+{
+public:
+    Private(FacetView *parent);
+    void refresh();
+
+private:
+    FacetView *q;
+public:
+    GStreamerLogModel *model = nullptr;
+    // rows come in by the chunk while loading, counting once in a while is enough
+    QTimer refreshTimer;
+};
+
+FacetView::Private::Private(FacetView *parent)
+    : q(parent)
+{
+    refreshTimer.setSingleShot(true);
+    refreshTimer.setInterval(500);
+    QObject::connect(&refreshTimer, &QTimer::timeout, q, [this]() {
+        refresh();
+    });
+}
+
+// Fills the values in again under the columns, most rows first, and keeps
+// which of the columns are expanded.
+void FacetView::Private::refresh()
+{
+    const auto &store = model->store();
+    auto fill = [this](int column, QList<QPair<QString, qsizetype>> &&counts) {
+        auto item = q->topLevelItem(column);
+        qDeleteAll(item->takeChildren());
+        std::stable_sort(counts.begin(), counts.end(), [](const auto &a, const auto &b) {
+            return a.second > b.second;
+        });
+        QList<QTreeWidgetItem *> children;
+        children.reserve(counts.count());
+        for (const auto &[value, count] : std::as_const(counts)) {
+            if (count == 0)
+                continue;
+            auto child = new QTreeWidgetItem({ value, QString::number(count) });
+            child->setTextAlignment(1, Qt::AlignRight);
+            children.append(child);
+        }
+        item->addChildren(children);
+        item->setText(1, QString::number(children.count()));
+    };
+
+    QList<QPair<QString, qsizetype>> processes;
+    processes.reserve(store.processes.count());
+    for (auto it = store.processes.cbegin(); it != store.processes.cend(); ++it)
+        processes.append({ QString::number(it.key()), it.value().count() });
+    fill(0, std::move(processes));
+
+    for (int i = 0; i < GStreamerLogStore::PostedCount; i++) {
+        const auto &strings = store.strings[GStreamerLogStore::symbol(GStreamerLogStore::PostedColumns[i])];
+        const auto &postings = store.postings[i];
+        QList<QPair<QString, qsizetype>> counts;
+        counts.reserve(postings.count());
+        for (qsizetype id = 0; id < postings.count(); id++)
+            counts.append({ strings.string(id), postings.at(id).count() });
+        fill(i + 1, std::move(counts));
+    }
+}
+
+FacetView::FacetView(QWidget *parent)
+    : QTreeWidget{parent}
+    , d(new Private(this))
+{
+    setColumnCount(2);
+    setHeaderLabels({ tr("Value"), tr("Rows") });
+    header()->setStretchLastSection(false);
+    header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    header()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    setUniformRowHeights(true);
+
+    addTopLevelItem(new QTreeWidgetItem({ QString::fromLatin1(GStreamerLogModel::Columns[GStreamerLogModel::PidColumn].name) }));
+    for (const auto column : GStreamerLogStore::PostedColumns)
+        addTopLevelItem(new QTreeWidgetItem({ QString::fromLatin1(GStreamerLogModel::Columns[column].name) }));
+
+    connect(this, &QTreeWidget::itemDoubleClicked, [this](QTreeWidgetItem *item) {
+        const auto parent = item->parent();
+        if (!parent)
+            return;
+        emit activated(QStringLiteral("%1:%2 ").arg(parent->text(0)).arg(item->text(0)));
+    });
+
+    connect(this, &FacetView::logModelChanged, [this](GStreamerLogModel *model) {
+        if (!model)
+            return;
+        // the store is only cleared after the rows are removed
+        auto schedule = [this]() {
+            if (!d->refreshTimer.isActive())
+                d->refreshTimer.start();
+        };
+        connect(model, &QAbstractItemModel::rowsInserted, this, schedule);
+        connect(model, &QAbstractItemModel::rowsRemoved, this, schedule);
+        d->refresh();
+    });
+}
+
+FacetView::~FacetView() = default;
+
+GStreamerLogModel *FacetView::logModel() const
+{
+    return d->model;
+}
+
+void FacetView::setLogModel(GStreamerLogModel *logModel)
+{
+    if (d->model == logModel) return;
+    if (d->model)
+        disconnect(d->model, nullptr, this, nullptr);
+    d->model = logModel;
+    emit logModelChanged(logModel);
+}
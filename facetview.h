@@ -0,0 +1,34 @@
+#ifndef FACETVIEW_H
+#define FACETVIEW_H
+
+#include <QtWidgets/QTreeWidget>
+
+class GStreamerLogModel;
+
+// Lists the values of Process, Thread, Level and Category with the number of
+// rows of each, read off the posting lists of the store. Double clicking a
+// value asks for it to be added to the filter.
+class FacetView : public QTreeWidget
+{
+    Q_OBJECT
+    Q_PROPERTY(GStreamerLogModel *logModel READ logModel WRITE setLogModel NOTIFY logModelChanged FINAL)
+public:
+    explicit FacetView(QWidget *parent = nullptr);
+    ~FacetView() override;
+
+    GStreamerLogModel *logModel() const;
+
+public slots:
+    void setLogModel(GStreamerLogModel *logModel);
+
+signals:
+    void logModelChanged(GStreamerLogModel *logModel);
+    // a Column:value term, the way GStreamerLogView::activated has it
+    void activated(const QString &text);
+
+private:
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+#endif // FACETVIEW_H
@@ -0,0 +1,728 @@
+#include "filterquery.h"
+#include "gstreamerlogmodel.h"
+#include "gstreamerlogstore.h"
+#include "rowbitmap.h"
+#include "timestamp.h"
+
+#include <QtCore/QRegularExpression>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+inline char fold(char c)
+{
+    return uchar(c) - uchar('A') < 26u ? char(c | 0x20) : c;
+}
+
+inline bool isLetter(char c)
+{
+    return uchar(c | 0x20) - uchar('a') < 26u;
+}
+
+// needle is lower case
+bool containsFolded(QByteArrayView haystack, QByteArrayView needle)
+{
+    if (needle.isEmpty())
+        return true;
+    if (haystack.size() < needle.size())
+        return false;
+
+    // a byte without case is found with memchr(), which is vectorized, and
+    // only the places it is at are compared
+    const qsizetype anchor = std::find_if_not(needle.begin(), needle.end(), isLetter) - needle.begin();
+    if (anchor < needle.size()) {
+        const char byte = needle.at(anchor);
+        const char *last = haystack.data() + haystack.size() - needle.size() + anchor + 1;
+        for (const char *p = haystack.data() + anchor; p < last; p++) {
+            p = static_cast<const char *>(std::memchr(p, byte, last - p));
+            if (!p)
+                return false;
+            const char *start = p - anchor;
+            qsizetype i = 0;
+            while (i < needle.size() && fold(start[i]) == needle.at(i))
+                i++;
+            if (i == needle.size())
+                return true;
+        }
+        return false;
+    }
+
+    // only letters: the first one is looked for in both cases with memchr(),
+    // keeping the next place of each until it is passed
+    const char lower = needle.front();
+    const char upper = char(lower & ~0x20);
+    const char *end = haystack.data() + haystack.size() - needle.size() + 1;
+    auto next = [end](const char *from, char byte) {
+        const auto p = static_cast<const char *>(std::memchr(from, byte, end - from));
+        return p ? p : end;
+    };
+    const char *lowerAt = next(haystack.data(), lower);
+    const char *upperAt = next(haystack.data(), upper);
+    while (lowerAt < end || upperAt < end) {
+        const char *p = qMin(lowerAt, upperAt);
+        qsizetype i = 1;
+        while (i < needle.size() && fold(p[i]) == needle.at(i))
+            i++;
+        if (i == needle.size())
+            return true;
+        if (p == lowerAt)
+            lowerAt = next(p + 1, lower);
+        else
+            upperAt = next(p + 1, upper);
+    }
+    return false;
+}
+
+// rows looked at to guess how many rows a clause lets through
+constexpr qsizetype SampleSize = 1024;
+
+constexpr qint64 Lowest = std::numeric_limits<qint64>::min();
+constexpr qint64 Highest = std::numeric_limits<qint64>::max();
+
+// Reads 1234, >1000, >=1000, <10, <=10, =1234, !=1234, 10..20, 10.. or ..20
+// into a range with both ends included, != as the range to leave out. For
+// timestamps the values are H:MM:SS.NNNNNNNNN or what is left of it, in
+// which case a plain value is not a range but text to look for.
+bool parseRange(QStringView keyword, bool timestamp, qint64 *low, qint64 *high, bool *unequal)
+{
+    auto value = [timestamp](QStringView text, qint64 *ret) {
+        if (text.isEmpty())
+            return false;
+        if (!timestamp) {
+            bool ok;
+            *ret = text.toLongLong(&ok);
+            return ok;
+        }
+        const bool valid = std::all_of(text.begin(), text.end(), [](QChar c) {
+            return (c >= QLatin1Char('0') && c <= QLatin1Char('9')) || c == QLatin1Char(':') || c == QLatin1Char('.');
+        });
+        if (valid)
+            *ret = Timestamp::fromString(QByteArrayView(text.toLatin1())).toNSecs();
+        return valid;
+    };
+
+    *low = Lowest;
+    *high = Highest;
+    *unequal = false;
+    const auto dots = keyword.indexOf(QLatin1String(".."));
+    if (dots >= 0) {
+        const auto from = keyword.left(dots);
+        const auto to = keyword.mid(dots + 2);
+        if (from.isEmpty() && to.isEmpty())
+            return false;
+        return (from.isEmpty() || value(from, low)) && (to.isEmpty() || value(to, high));
+    }
+    qint64 v;
+    if (keyword.startsWith(QLatin1String(">=")))
+        return value(keyword.mid(2), low);
+    if (keyword.startsWith(QLatin1String("<=")))
+        return value(keyword.mid(2), high);
+    if (keyword.startsWith(QLatin1String("!="))) {
+        *unequal = true;
+        keyword = keyword.mid(2);
+    } else if (keyword.startsWith(QLatin1Char('>'))) {
+        if (!value(keyword.mid(1), &v) || v == Highest)
+            return false;
+        *low = v + 1;
+        return true;
+    } else if (keyword.startsWith(QLatin1Char('<'))) {
+        if (!value(keyword.mid(1), &v) || v == Lowest)
+            return false;
+        *high = v - 1;
+        return true;
+    } else if (keyword.startsWith(QLatin1Char('='))) {
+        keyword = keyword.mid(1);
+    } else if (timestamp) {
+        return false;
+    }
+    if (!value(keyword, &v))
+        return false;
+    *low = v;
+    *high = v;
+    return true;
+}
+
+// index past the ']' that closes the class opening at i
+qsizetype skipClass(const QString &pattern, qsizetype i)
+{
+    i++;
+    if (i < pattern.size() && pattern.at(i) == QLatin1Char('^'))
+        i++;
+    // a ']' right at the start is part of the class
+    if (i < pattern.size() && pattern.at(i) == QLatin1Char(']'))
+        i++;
+    for (; i < pattern.size(); i++) {
+        if (pattern.at(i) == QLatin1Char('\\'))
+            i++;
+        else if (pattern.at(i) == QLatin1Char(']'))
+            return i + 1;
+    }
+    return pattern.size();
+}
+
+// index past the ')' that closes the group opening at i
+qsizetype skipGroup(const QString &pattern, qsizetype i)
+{
+    int depth = 0;
+    while (i < pattern.size()) {
+        const auto c = pattern.at(i);
+        if (c == QLatin1Char('\\')) {
+            i += 2;
+            continue;
+        }
+        if (c == QLatin1Char('[')) {
+            i = skipClass(pattern, i);
+            continue;
+        }
+        i++;
+        if (c == QLatin1Char('('))
+            depth++;
+        else if (c == QLatin1Char(')') && --depth == 0)
+            return i;
+    }
+    return pattern.size();
+}
+
+// Substrings of ASCII every match of pattern has, in lower case. Whatever the
+// scan does not follow ends a literal, so it may miss some but never returns
+// one that a match can do without.
+QList<QByteArray> requiredLiterals(const QString &pattern)
+{
+    static const QRegularExpression extended(QStringLiteral("\\(\\?[a-zA-Z^-]*x"));
+    if (pattern.contains(extended))
+        return {};
+
+    QList<QByteArray> ret;
+    QByteArray literal;
+    auto end = [&]() {
+        if (!literal.isEmpty())
+            ret.append(std::exchange(literal, QByteArray()));
+    };
+    for (qsizetype i = 0; i < pattern.size(); ) {
+        const auto c = pattern.at(i);
+        char byte = 0;
+        qsizetype next = i + 1;
+        if (c == QLatin1Char('\\')) {
+            const auto escaped = i + 1 < pattern.size() ? pattern.at(i + 1) : QChar();
+            next = i + 2;
+            if (escaped == QLatin1Char('Q')) {
+                // \Q...\E quotes, not worth following
+                const auto quoteEnd = pattern.indexOf(QLatin1String("\\E"), next);
+                next = quoteEnd < 0 ? pattern.size() : quoteEnd + 2;
+            } else if (escaped.unicode() > 0 && escaped.unicode() < 0x80 && !escaped.isLetterOrNumber()) {
+                byte = escaped.toLatin1();
+            } else {
+                // \d, \b, \x41, \p{L}, \1 and the like, with whatever follows them
+                while (next < pattern.size() && (pattern.at(next).isLetterOrNumber() || QStringLiteral("{}<>'").contains(pattern.at(next))))
+                    next++;
+            }
+        } else if (c == QLatin1Char('|')) {
+            // either side may match, groups were skipped as a whole
+            return {};
+        } else if (c == QLatin1Char('(')) {
+            next = skipGroup(pattern, i);
+        } else if (c == QLatin1Char('[')) {
+            next = skipClass(pattern, i);
+        } else if (c.unicode() < 0x80 && !QStringLiteral(".^$)]{}*+?").contains(c)) {
+            byte = c.toLatin1();
+        }
+
+        // a quantifier after the atom
+        bool optional = false;
+        bool repeated = false;
+        if (next < pattern.size()) {
+            const auto quantifier = pattern.at(next);
+            if (quantifier == QLatin1Char('?') || quantifier == QLatin1Char('*')) {
+                optional = true;
+                next++;
+            } else if (quantifier == QLatin1Char('+')) {
+                repeated = true;
+                next++;
+            } else if (quantifier == QLatin1Char('{')) {
+                // {0,n} and {,n}
+                optional = next + 1 < pattern.size() && (pattern.at(next + 1) == QLatin1Char('0') || pattern.at(next + 1) == QLatin1Char(','));
+                repeated = true;
+                const auto close = pattern.indexOf(QLatin1Char('}'), next);
+                next = close < 0 ? pattern.size() : close + 1;
+            }
+            // lazy and possessive forms
+            if ((optional || repeated) && next < pattern.size() && (pattern.at(next) == QLatin1Char('?') || pattern.at(next) == QLatin1Char('+')))
+                next++;
+        }
+
+        if (byte && !optional) {
+            literal.append(fold(byte));
+            if (repeated)
+                end();
+        } else {
+            end();
+        }
+        i = next;
+    }
+    end();
+    return ret;
+}
+
+}
+
+FilterQuery::FilterQuery(const QString &text)
+{
+    bool either = false;
+    for (qsizetype i = 0; i < text.size(); ) {
+        const auto first = text.at(i);
+        if (first.isSpace()) {
+            i++;
+            continue;
+        }
+        if (first == QLatin1Char('|')) {
+            either = true;
+            i++;
+            continue;
+        }
+
+        // one term, quotes keep spaces, '|' and ':' in it
+        QString token;
+        qsizetype colon = -1;
+        bool negated = false;
+        bool quoted = false;
+        bool regular = false;
+        QString pattern;
+        for (; i < text.size(); i++) {
+            const auto c = text.at(i);
+            // re:/pattern/ is taken as it is up to the closing slash, \/ is a slash
+            if (c == QLatin1Char('/') && !quoted && !regular && token.endsWith(QLatin1String("re:"))
+                    && (token.size() == 3 || token.size() == colon + 4)) {
+                regular = true;
+                for (i++; i < text.size() && text.at(i) != QLatin1Char('/'); i++) {
+                    if (text.at(i) == QLatin1Char('\\') && i + 1 < text.size()) {
+                        i++;
+                        if (text.at(i) != QLatin1Char('/'))
+                            pattern.append(QLatin1Char('\\'));
+                    }
+                    pattern.append(text.at(i));
+                }
+                continue;
+            }
+            if (c == QLatin1Char('"')) {
+                quoted = !quoted;
+                continue;
+            }
+            if (!quoted) {
+                if (c.isSpace() || c == QLatin1Char('|'))
+                    break;
+                if (c == QLatin1Char('-') && token.isEmpty() && !negated) {
+                    negated = true;
+                    continue;
+                }
+                if (c == QLatin1Char(':') && colon < 0)
+                    colon = token.size();
+            }
+            token.append(c);
+        }
+        // a lone '-' is a keyword
+        if (negated && token.isEmpty() && text.at(i - 1) == QLatin1Char('-')) {
+            token = QStringLiteral("-");
+            negated = false;
+        }
+
+        Term term;
+        term.column = colon < 0 ? -1 : GStreamerLogModel::column(QStringView(token).left(colon));
+        if (term.column < 0) {
+            term.column = GStreamerLogModel::MessageColumn;
+            term.keyword = token;
+        } else {
+            term.keyword = token.mid(colon + 1);
+        }
+        term.symbol = GStreamerLogStore::symbol(term.column);
+        term.negated = negated;
+        term.ascii = std::all_of(term.keyword.cbegin(), term.keyword.cend(), [](QChar c) {
+            return c.unicode() < 0x80;
+        });
+        if (term.ascii)
+            term.folded = term.keyword.toLatin1().toLower();
+        const auto type = GStreamerLogModel::Columns[term.column].type;
+        if (!regular && type != GStreamerLogModel::TextType) {
+            bool unequal;
+            term.ranged = parseRange(term.keyword, type == GStreamerLogModel::TimestampType, &term.low, &term.high, &unequal);
+            if (term.ranged) {
+                term.negated = term.negated != unequal;
+            } else if (type == GStreamerLogModel::NumberType) {
+                if (error.isEmpty())
+                    error = QStringLiteral("%1: expected a number or a range such as 10..20, >10 or !=10").arg(token);
+                // matches nothing
+                term.ranged = true;
+                term.low = 1;
+                term.high = 0;
+            }
+        }
+        term.regular = regular;
+        if (regular) {
+            term.keyword = pattern;
+            term.ascii = false;
+            term.regex = QRegularExpression(pattern, QRegularExpression::CaseInsensitiveOption);
+            // compiled here, and just in time, instead of on the first row
+            term.regex.optimize();
+            term.literals = requiredLiterals(pattern);
+            term.folded.clear();
+            for (const auto &literal : std::as_const(term.literals)) {
+                if (literal.size() > term.folded.size())
+                    term.folded = literal;
+            }
+        }
+
+        if (either && !clauses.isEmpty())
+            clauses.last().terms.append(term);
+        else
+            clauses.append(Clause { { term } });
+        either = false;
+    }
+
+    // text is matched ignoring case and OR does not care about order
+    for (auto &clause : clauses) {
+        QStringList keys;
+        for (const auto &term : std::as_const(clause.terms)) {
+            const auto &info = GStreamerLogModel::Columns[term.column];
+            QString keyword;
+            if (term.regular)
+                keyword = QStringLiteral("re:/%1/").arg(term.keyword);
+            else if (term.ranged)
+                keyword = QStringLiteral("%1..%2").arg(term.low == Lowest ? QString() : QString::number(term.low), term.high == Highest ? QString() : QString::number(term.high));
+            else
+                keyword = term.keyword.toCaseFolded();
+            keys.append(QStringLiteral("%1%2:%3").arg(term.negated ? QStringLiteral("-") : QString(), QLatin1String(info.name), keyword));
+        }
+        keys.sort();
+        keys.removeDuplicates();
+        clause.key = keys.join(QLatin1Char('|'));
+    }
+}
+
+QString FilterQuery::errorString() const
+{
+    if (!error.isEmpty())
+        return error;
+    for (const auto &clause : clauses) {
+        for (const auto &term : clause.terms) {
+            if (term.regular && !term.regex.isValid())
+                return QStringLiteral("re:/%1/: %2").arg(term.keyword, term.regex.errorString());
+        }
+    }
+    return QString();
+}
+
+QSet<QString> FilterQuery::keys() const
+{
+    QSet<QString> ret;
+    for (const auto &clause : clauses)
+        ret.insert(clause.key);
+    return ret;
+}
+
+QString FilterQuery::key() const
+{
+    auto ret = keys().values();
+    ret.sort();
+    return ret.join(QLatin1Char(' '));
+}
+
+FilterQuery FilterQuery::without(const QSet<QString> &keys) const
+{
+    FilterQuery ret;
+    for (const auto &clause : clauses) {
+        if (!keys.contains(clause.key))
+            ret.clauses.append(clause);
+    }
+    return ret;
+}
+
+void FilterQuery::prepare(const GStreamerLogStore &store)
+{
+    for (auto &clause : clauses) {
+        for (auto &term : clause.terms) {
+            if (term.symbol < 0)
+                continue;
+            const auto &strings = store.strings[term.symbol];
+            // the tables start over when the log is reloaded
+            if (term.strings.count() > strings.count())
+                term.strings.clear();
+            for (auto id = term.strings.count(); id < strings.count(); id++)
+                term.strings.append(term.containsString(strings.string(id)));
+        }
+    }
+
+    // For independent clauses the cheapest order sorts by cost over the share
+    // of rows a clause rejects, which a sample spread over the log estimates.
+    const auto count = store.count();
+    const auto samples = qMin(count, SampleSize);
+    for (auto &clause : clauses) {
+        std::sort(clause.terms.begin(), clause.terms.end(), [](const Term &a, const Term &b) {
+            return a.cost() < b.cost();
+        });
+        int cost = 0;
+        for (const auto &term : std::as_const(clause.terms))
+            cost += term.cost();
+        qsizetype passed = 0;
+        for (qsizetype i = 0; i < samples; i++)
+            passed += clause.matches(store, i * count / samples);
+        const auto rejected = samples > 0 ? double(samples - passed) / samples : 0.5;
+        clause.rank = cost / qMax(rejected, 0.001);
+    }
+    std::stable_sort(clauses.begin(), clauses.end(), [](const Clause &a, const Clause &b) {
+        return a.rank < b.rank;
+    });
+}
+
+bool FilterQuery::matches(const GStreamerLogStore &store, qsizetype row) const
+{
+    for (const auto &clause : clauses) {
+        if (!clause.matches(store, row))
+            return false;
+    }
+    return true;
+}
+
+bool FilterQuery::lookup(const GStreamerLogStore &store, RowBitmap *candidates, FilterQuery *rest) const
+{
+    bool ret = false;
+    *rest = FilterQuery();
+    for (const auto &clause : clauses) {
+        const bool posted = std::all_of(clause.terms.cbegin(), clause.terms.cend(), [](const Term &term) {
+            return term.isPosted();
+        });
+        const bool indexed = !posted && store.trigrams.size() > 0 && std::all_of(clause.terms.cbegin(), clause.terms.cend(), [](const Term &term) {
+            return term.isIndexed();
+        });
+        // the trigrams only tell which rows can not match
+        if (!posted)
+            rest->clauses.append(clause);
+        if (!posted && !indexed)
+            continue;
+        RowBitmap rows(store.count());
+        for (const auto &term : clause.terms) {
+            if (posted)
+                term.post(store, &rows);
+            else
+                store.trigrams.candidates(term.folded, &rows);
+        }
+        if (ret) {
+            *candidates &= rows;
+        } else {
+            rows.update();
+            *candidates = std::move(rows);
+            ret = true;
+        }
+    }
+    return ret;
+}
+
+quint16 FilterQuery::mask(const GStreamerLogStore &store, qsizetype row) const
+{
+    quint16 ret = 0;
+    for (const auto &clause : clauses) {
+        if (clause.terms.count() == 1) {
+            // the row would not be accepted otherwise
+            if (!clause.terms.first().negated)
+                ret |= 1 << clause.terms.first().column;
+            continue;
+        }
+        for (const auto &term : clause.terms) {
+            if (!term.negated && !(ret >> term.column & 1) && term.matches(store, row))
+                ret |= 1 << term.column;
+        }
+    }
+    return ret;
+}
+
+QList<FilterQuery::Span> FilterQuery::spans(const GStreamerLogStore &store, qsizetype row, int column) const
+{
+    QList<Span> ret;
+    QString text;
+    for (const auto &clause : clauses) {
+        for (const auto &term : clause.terms) {
+            if (term.column != column || term.negated || !term.matches(store, row))
+                continue;
+            if (text.isNull())
+                text = store.text(row, column);
+            term.spans(text, &ret);
+        }
+    }
+    return ret;
+}
+
+bool FilterQuery::interval(const GStreamerLogStore &store, qsizetype *first, qsizetype *last, FilterQuery *rest) const
+{
+    bool ret = false;
+    *rest = FilterQuery();
+    const auto &timestamps = store.rows.timestamp;
+    const auto &order = store.order;
+    for (const auto &clause : clauses) {
+        if (clause.terms.count() != 1 || !clause.terms.first().isInterval()) {
+            rest->clauses.append(clause);
+            continue;
+        }
+        const auto &term = clause.terms.first();
+        const auto begin = std::partition_point(order.cbegin(), order.cend(), [&](quint32 row) {
+            return timestamps.at(row) < term.low;
+        });
+        const auto end = std::partition_point(begin, order.cend(), [&](quint32 row) {
+            return timestamps.at(row) <= term.high;
+        });
+        *first = qMax<qsizetype>(*first, begin - order.cbegin());
+        *last = qMin<qsizetype>(*last, end - order.cbegin());
+        ret = true;
+    }
+    if (*last < *first)
+        *last = *first;
+    return ret;
+}
+
+bool FilterQuery::highlights(const GStreamerLogStore &store, qsizetype row, int column) const
+{
+    for (const auto &clause : clauses) {
+        for (const auto &term : clause.terms) {
+            if (term.column == column && !term.negated && term.matches(store, row))
+                return true;
+        }
+    }
+    return false;
+}
+
+int FilterQuery::Term::cost() const
+{
+    int ret;
+    switch (column) {
+    case GStreamerLogModel::PidColumn:
+    case GStreamerLogModel::LineColumn:
+        ret = 1;
+        break;
+    case GStreamerLogModel::TimestampColumn:
+        ret = ranged ? 1 : 4;
+        break;
+    case GStreamerLogModel::MessageColumn:
+        ret = 16;
+        break;
+    default:
+        // a table lookup unless the string came in after prepare()
+        ret = 1;
+        break;
+    }
+    // non-ASCII keywords and regular expressions decode every value
+    if (symbol < 0 && !ascii)
+        ret *= 8;
+    return ret;
+}
+
+// Regular expressions only run where the literals they need are
+bool FilterQuery::Term::contains(QByteArrayView text) const
+{
+    if (ascii)
+        return containsFolded(text, folded);
+    if (regular) {
+        for (const auto &literal : literals) {
+            if (!containsFolded(text, literal))
+                return false;
+        }
+    }
+    return containsString(QString::fromUtf8(text));
+}
+
+bool FilterQuery::Term::containsString(const QString &text) const
+{
+    if (regular)
+        return regex.match(text).hasMatch();
+    return text.contains(keyword, Qt::CaseInsensitive);
+}
+
+bool FilterQuery::Term::matches(const GStreamerLogStore &store, qsizetype row) const
+{
+    bool ret;
+    if (ranged) {
+        qint64 value;
+        if (column == GStreamerLogModel::PidColumn)
+            value = store.rows.pid.at(row);
+        else if (column == GStreamerLogModel::LineColumn)
+            value = store.rows.line.at(row);
+        else
+            value = store.rows.timestamp.at(row);
+        ret = low <= value && value <= high;
+    } else if (symbol >= 0) {
+        ret = matchesSymbol(store, store.rows.symbols[symbol].at(row));
+    } else if (column == GStreamerLogModel::PidColumn) {
+        ret = containsString(QString::number(store.rows.pid.at(row)));
+    } else if (column == GStreamerLogModel::LineColumn) {
+        ret = containsString(QString::number(store.rows.line.at(row)));
+    } else {
+        ret = contains(store.bytes(row, column));
+    }
+    return ret != negated;
+}
+
+bool FilterQuery::Term::matchesSymbol(const GStreamerLogStore &store, qsizetype id) const
+{
+    return id < strings.count() ? strings.at(id) : containsString(store.strings[symbol].string(id));
+}
+
+// a negated term would need every row it does not list
+bool FilterQuery::Term::isPosted() const
+{
+    return !negated && ((column == GStreamerLogModel::PidColumn && ranged) || GStreamerLogStore::posted(column) >= 0);
+}
+
+bool FilterQuery::Term::isInterval() const
+{
+    return !negated && ranged && column == GStreamerLogModel::TimestampColumn;
+}
+
+// for a regular expression folded is its longest literal
+bool FilterQuery::Term::isIndexed() const
+{
+    return !negated && column == GStreamerLogModel::MessageColumn && (ascii || regular) && folded.size() >= 3;
+}
+
+void FilterQuery::Term::spans(const QString &text, QList<Span> *ret) const
+{
+    if (regular) {
+        for (auto it = regex.globalMatch(text); it.hasNext(); ) {
+            const auto match = it.next();
+            if (match.capturedLength() > 0)
+                ret->append({ match.capturedStart(), match.capturedLength() });
+        }
+    } else if (ranged) {
+        ret->append({ 0, text.size() });
+    } else if (!keyword.isEmpty()) {
+        for (auto i = text.indexOf(keyword, 0, Qt::CaseInsensitive); i >= 0; i = text.indexOf(keyword, i + keyword.size(), Qt::CaseInsensitive))
+            ret->append({ i, keyword.size() });
+    }
+}
+
+void FilterQuery::Term::post(const GStreamerLogStore &store, RowBitmap *rows) const
+{
+    auto set = [rows](const QList<quint32> &list) {
+        for (const auto row : list)
+            rows->setBit(row);
+    };
+    if (column == GStreamerLogModel::PidColumn) {
+        for (auto it = store.processes.cbegin(); it != store.processes.cend(); ++it) {
+            if (low <= it.key() && it.key() <= high)
+                set(it.value());
+        }
+        return;
+    }
+    const auto &postings = store.postings[GStreamerLogStore::posted(column)];
+    for (qsizetype id = 0; id < postings.count(); id++) {
+        if (matchesSymbol(store, id))
+            set(postings.at(id));
+    }
+}
+
+bool FilterQuery::Clause::matches(const GStreamerLogStore &store, qsizetype row) const
+{
+    for (const auto &term : terms) {
+        if (term.matches(store, row))
+            return true;
+    }
+    return false;
+}
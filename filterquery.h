@@ -0,0 +1,135 @@
+#ifndef FILTERQUERY_H
+#define FILTERQUERY_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+class GStreamerLogStore;
+class RowBitmap;
+
+// A filter as it is typed, compiled once into clauses that are evaluated
+// straight against GStreamerLogStore, without a QString or QVariant per row.
+//
+//   keyword         Message contains keyword
+//   Column:keyword  Column contains keyword, Process and Line are compared by value
+//   "a b"           a phrase with spaces, also Column:"a b"
+//   re:/pattern/    Message matches the regular expression, also Column:re:/pattern/
+//   Column:a..b     Process, Line or Timestamp from a to b, either may be left out
+//   Column:>a       also >=, <, <=, = and !=, e.g. Line:>1000 or Process:!=1234
+//   -term           rows term does not match
+//   a|b             rows either term matches, also a | b
+//
+// A row is accepted when every clause matches. Text is compared
+// case-insensitively, by regular expressions too; they only run on the rows
+// that have the literal text the pattern requires.
+class FilterQuery
+{
+public:
+    FilterQuery() = default;
+    explicit FilterQuery(const QString &text);
+
+    bool isEmpty() const { return clauses.isEmpty(); }
+    // what is wrong with the first invalid term, if any
+    QString errorString() const;
+
+    // The clauses in a canonical form, with the case of text and the order of
+    // OR terms folded. A query whose keys contain those of another only
+    // accepts rows the other one accepts.
+    QSet<QString> keys() const;
+    // all keys in order, equal for queries that only differ in the order of
+    // their terms, case or spacing
+    QString key() const;
+    // the clauses whose keys are not in keys
+    FilterQuery without(const QSet<QString> &keys) const;
+
+    // Resolves the terms against the string tables of store and orders the
+    // clauses so that cheap and selective ones run first. Call it again after
+    // rows were added: strings that came in since are matched correctly, just
+    // more slowly.
+    void prepare(const GStreamerLogStore &store);
+
+    bool matches(const GStreamerLogStore &store, qsizetype row) const;
+    // Answers the clauses on Process and the posted columns from the posting
+    // lists of store and narrows Message keywords down with its trigram
+    // index: candidates gets the store rows they all let through and rest the
+    // clauses left to match row by row. False if there were none.
+    bool lookup(const GStreamerLogStore &store, RowBitmap *candidates, FilterQuery *rest) const;
+    // Answers the Timestamp ranges with two binary searches over the rows in
+    // timestamp order: narrows the model rows [first, last) down to the ones
+    // they let through and leaves the other clauses in rest. False if there
+    // were none.
+    bool interval(const GStreamerLogStore &store, qsizetype *first, qsizetype *last, FilterQuery *rest) const;
+    // whether a term that is not negated matches column of row
+    bool highlights(const GStreamerLogStore &store, qsizetype row, int column) const;
+    // A bit per column of a row the query accepts, set where highlights()
+    // is true. Only the terms of OR clauses need to be matched for it.
+    quint16 mask(const GStreamerLogStore &store, qsizetype row) const;
+
+    // a range of the text of a column, in QChars
+    struct Span {
+        qsizetype start;
+        qsizetype length;
+    };
+    // what the terms that are not negated match in column of row
+    QList<Span> spans(const GStreamerLogStore &store, qsizetype row, int column) const;
+
+private:
+    struct Term
+    {
+        int column;
+        // index into the store's symbols, -1 if column is not a symbol column
+        int symbol;
+        bool negated;
+        QString keyword;
+        // keyword in lower case if it is ASCII, else matching needs a QString
+        bool ascii;
+        QByteArray folded;
+        // the values of Process, Line or Timestamp it matches, both included
+        bool ranged = false;
+        qint64 low;
+        qint64 high;
+        // keyword is the pattern of regex, which only matches text that has
+        // all the literals in lower case; folded is the longest of them
+        bool regular = false;
+        QRegularExpression regex;
+        QList<QByteArray> literals;
+        // per string of a symbol column, whether it contains keyword
+        QList<bool> strings;
+
+        int cost() const;
+        bool contains(QByteArrayView text) const;
+        bool containsString(const QString &text) const;
+        bool matches(const GStreamerLogStore &store, qsizetype row) const;
+        // whether the string id of the symbol column contains keyword
+        bool matchesSymbol(const GStreamerLogStore &store, qsizetype id) const;
+        bool isPosted() const;
+        // whether the trigram index can tell the rows it may match
+        bool isIndexed() const;
+        // whether it is a Timestamp range, see interval()
+        bool isInterval() const;
+        // sets the store rows it matches
+        void post(const GStreamerLogStore &store, RowBitmap *rows) const;
+        void spans(const QString &text, QList<Span> *ret) const;
+    };
+
+    struct Clause
+    {
+        // any of them
+        QList<Term> terms;
+        // the terms as parsed, see keys()
+        QString key;
+        // expected cost per rejected row, clauses run in ascending rank
+        double rank = 0;
+
+        bool matches(const GStreamerLogStore &store, qsizetype row) const;
+    };
+
+    QList<Clause> clauses;
+    QString error;
+};
+
+#endif // FILTERQUERY_H
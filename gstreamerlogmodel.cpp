@@ -1,39 +1,958 @@
 #include "gstreamerlogmodel.h"
+#include "gstreamerlogstore.h"
+#include "gstreamerlogtokenizer.h"
 #include "timestamp.h"
 
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
 #include <QtCore/QFile>
-#include <QtCore/QMetaProperty>
-#include <QtCore/QRegularExpression>
-#include <QtCore/QTextStream>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QFuture>
+#include <QtCore/QMutex>
+#include <QtCore/QSaveFile>
+#include <QtCore/QScopeGuard>
+#include <QtCore/QSet>
+#include <QtCore/QSettings>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtGui/QColor>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+
 class GStreamerLogModel::Private
 {
+public:
+    using Rows = GStreamerLogStore::Rows;
+    static constexpr int SymbolCount = GStreamerLogStore::SymbolCount;
+    static constexpr auto &SymbolColumns = GStreamerLogStore::SymbolColumns;
+    static constexpr int symbol(int column) { return GStreamerLogStore::symbol(column); }
+
+    // A range of the file parsed by one worker. Rows::id counts lines from
+    // the start of the chunk, order, postings and processes index rows and
+    // Rows::symbols index the values of the chunk until the chunk is merged
+    // into the store.
+    struct Chunk
+    {
+        qint64 begin = 0;
+        qint64 end = 0;
+        int lines = 0;
+        Rows rows;
+        QList<quint32> order;
+        std::array<GStreamerLogStore::Postings, GStreamerLogStore::PostedCount> postings;
+        QHash<int, QList<quint32>> processes;
+        std::array<QList<QByteArray>, SymbolCount> symbols;
+    };
+
+    // Layout of the index file: the header, each array of Rows in turn,
+    // quint32 order[count] and the values of each string table.
+    // Arrays are stored as they are in memory, so the index is only good for
+    // a build with the same byte order; version and rowSize catch the rest.
+    struct IndexHeader
+    {
+        char magic[8];
+        quint32 version;
+        // bytes per row over all arrays
+        quint32 rowSize;
+        // bytes of the log covered by the index and its mtime at that time
+        qint64 size;
+        qint64 modified;
+        qint64 lines;
+        qint64 count;
+        char digest[20];
+    };
+    static constexpr char IndexMagic[8] = "GLVINDX";
+    static constexpr quint32 IndexVersion = 5;
+    static quint32 rowSize();
+
+    Private(const QString &fileName, GStreamerLogModel *parent);
+    ~Private();
+
+    bool map();
+    void unmap();
+    bool isReplaced() const;
+    qint64 complete(qint64 begin, qint64 end) const;
+    QList<Chunk> split(qint64 begin, qint64 end) const;
+    void parse(Chunk *chunk) const;
+    QList<quint32> sort(const Rows &rows) const;
+    void post(Chunk *chunk) const;
+
+    QString indexPath() const;
+    QByteArray digest(qint64 end) const;
+    bool readIndex(Chunk *chunk, qint64 end);
+    void writeIndex();
+
+    void start(qint64 begin, qint64 end);
+    void load(qint64 begin, qint64 end);
+    void stop();
+    void publish();
+    void insert(Chunk &chunk);
+    void unloadLast();
+    void updateColors(const Chunk &chunk);
+    void follow();
+
+    void buildTrigrams();
+    TrigramIndex indexTrigrams(qsizetype from, qsizetype to, qsizetype budget) const;
+    void mergeTrigrams();
+    void stopTrigrams();
+
+private:
+    GStreamerLogModel *q;
+
 public:
     QString fileName;
-    QList<GStreamerLogLine> lines;
-    static const QMetaObject *mo;
+    QFile file;
+    const char *data = nullptr;
+    qint64 size = 0;
+    GStreamerLogStore store;
+    int lines = 0;
+    // end of the bytes turned into rows so far
+    qint64 loaded = 0;
+    // start of the last line turned into rows when it had no newline yet, so
+    // that it is parsed again if the writer was not done with it; -1 if it had
+    qint64 unterminated = -1;
     QMap<int, QColor> processColorMap;
-    QHash<QString, QColor> threadColorMap;
+    // indexed by thread id
+    QList<QColor> threadColors;
+
+    // parsed chunks travel from the loader thread to publish() through pending
+    QThread *loader = nullptr;
+    std::atomic<bool> canceled = false;
+    QMutex mutex;
+    QList<Chunk> pending;
+    bool parsed = false;
+    bool suspended = false;
+    bool publishing = false;
+
+    // in follow mode only the bytes appended after loaded are parsed
+    bool following = false;
+    bool tail = false;
+    // the size of the file when follow() last saw a line without a newline at
+    // its end, which is taken as complete once the size stays the same
+    qint64 settled = -1;
+    QFileSystemWatcher watcher;
+    QTimer poll;
+
+    // optional on-disk copy of the store, see readIndex()
+    bool indexing = false;
+    qint64 indexed = 0;
+    QFuture<void> writer;
+
+    // the trigram index is built by a thread of its own once nothing is
+    // loading, and handed over through trigramPart like the chunks
+    QThread *trigramBuilder = nullptr;
+    std::atomic<bool> trigramCanceled = false;
+    TrigramIndex trigramPart;
+    bool trigramsBuilt = false;
  };
 
-const QMetaObject *GStreamerLogModel::Private::mo = &GStreamerLogLine::staticMetaObject;
+GStreamerLogModel::Private::Private(const QString &fileName, GStreamerLogModel *parent)
+    : q(parent)
+    , fileName(fileName)
+    , file(fileName)
+{
+    // writers append in small pieces, handle them together
+    poll.setSingleShot(true);
+    poll.setInterval(100);
+    QObject::connect(&watcher, &QFileSystemWatcher::fileChanged, &poll, qOverload<>(&QTimer::start));
+    QObject::connect(&poll, &QTimer::timeout, q, [this]() {
+        follow();
+    });
+}
+
+GStreamerLogModel::Private::~Private()
+{
+    stopTrigrams();
+    stop();
+    writer.waitForFinished();
+    unmap();
+}
+
+// Maps the whole file, or maps it again when it has grown since
+bool GStreamerLogModel::Private::map()
+{
+    if (!file.isOpen() && !file.open(QIODevice::ReadOnly))
+        return false;
+    const auto available = file.size();
+    if (data && available == size)
+        return true;
+    // the builder reads the mapping, whatever size was seen before this
+    stopTrigrams();
+    if (data)
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+    data = nullptr;
+    size = available;
+    if (size > 0)
+        data = reinterpret_cast<const char *>(file.map(0, size));
+    store.data = data;
+    if (!data) {
+        file.close();
+        size = 0;
+        return false;
+    }
+    return true;
+}
+
+void GStreamerLogModel::Private::unmap()
+{
+    if (data)
+        file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+    data = nullptr;
+    store.data = nullptr;
+    size = 0;
+    file.close();
+}
+
+// Whether the file at fileName is no longer the one that is mapped, because it
+// was rotated or a restarted writer created it again. The open file keeps the
+// one it was opened on, so the heads of both are compared; a few KiB tell
+// apart logs whose first lines have different timestamps, pids or threads.
+bool GStreamerLogModel::Private::isReplaced() const
+{
+    if (!data || loaded == 0)
+        return false;
+    QFile current(fileName);
+    if (!current.open(QIODevice::ReadOnly))
+        return false;
+    const auto head = current.read(qMin<qint64>(loaded, 4096));
+    return head != QByteArrayView(data, qMin<qint64>(loaded, 4096));
+}
+
+// Returns the end of the last complete line in [begin, end), begin if there is
+// none. The writer may still be in the middle of the line after it.
+qint64 GStreamerLogModel::Private::complete(qint64 begin, qint64 end) const
+{
+    while (end > begin && data[end - 1] != '\n')
+        end--;
+    return end;
+}
+
+// The first chunk is small so that the first screen shows up right away, the
+// following ones grow to keep the number of batches low on huge files.
+QList<GStreamerLogModel::Private::Chunk> GStreamerLogModel::Private::split(qint64 begin, qint64 end) const
+{
+    QList<Chunk> ret;
+    qint64 step = 1 << 20;
+    const qint64 last = end;
+    while (begin < last) {
+        end = qMin(begin + step, last);
+        if (end < last) {
+            const auto eol = static_cast<const char *>(std::memchr(data + end, '\n', last - end));
+            end = eol ? eol - data + 1 : last;
+        }
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        ret.append(chunk);
+        begin = end;
+        step = qMin<qint64>(step * 2, 32 << 20);
+    }
+    return ret;
+}
+
+void GStreamerLogModel::Private::parse(Chunk *chunk) const
+{
+    GStreamerLogTokenizer tokenizer;
+    QHash<QByteArrayView, quint32> symbols[SymbolCount];
+    // by level symbol of the chunk
+    QList<Level> levels;
+    const char *end = data + chunk->end;
+    int l = 0;
+    for (const char *p = data + chunk->begin; p < end; ) {
+        if (canceled.load(std::memory_order_relaxed))
+            return;
+        l++;
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+        if (!eol)
+            eol = end;
+        qsizetype length = eol - p;
+        if (length > 0 && p[length - 1] == '\r')
+            length--;
+        if (tokenizer.tokenize(QByteArrayView(p, length))) {
+            auto &rows = chunk->rows;
+            rows.offset.append(p - data);
+            rows.length.append(length);
+            rows.id.append(l);
+            rows.timestamp.append(tokenizer.timestamp);
+            rows.pid.append(tokenizer.pid);
+            rows.line.append(tokenizer.line);
+            for (int i = 0; i < SymbolCount; i++) {
+                const auto value = tokenizer.field(SymbolColumns[i]);
+                auto it = symbols[i].constFind(value);
+                if (it == symbols[i].constEnd()) {
+                    it = symbols[i].insert(value, chunk->symbols[i].count());
+                    // points into the mapping, StringTable copies what it keeps
+                    chunk->symbols[i].append(QByteArray::fromRawData(value.data(), value.size()));
+                }
+                rows.symbols[i].append(it.value());
+            }
+            const auto levelSymbol = rows.symbols[symbol(LevelColumn)].last();
+            if (qsizetype(levelSymbol) == levels.count())
+                levels.append(GStreamerLogModel::level(tokenizer.field(LevelColumn)));
+            rows.level.append(levels.at(levelSymbol));
+            rows.timestampEnd.append(tokenizer.end[TimestampColumn]);
+            rows.message.append(tokenizer.begin[MessageColumn]);
+        } else {
+            qWarning() << QString::fromUtf8(p, length);
+        }
+        p = eol + 1;
+    }
+    chunk->lines = l;
+    chunk->order = sort(chunk->rows);
+    post(chunk);
+}
+
+// Collects the rows of each value of the posted columns and each process,
+// so that the GUI thread only has to append them to the store's.
+void GStreamerLogModel::Private::post(Chunk *chunk) const
+{
+    const auto &rows = chunk->rows;
+    const auto count = rows.count();
+    for (int i = 0; i < GStreamerLogStore::PostedCount; i++) {
+        const auto &ids = rows.symbols[symbol(GStreamerLogStore::PostedColumns[i])];
+        auto &postings = chunk->postings[i];
+        postings.resize(chunk->symbols[symbol(GStreamerLogStore::PostedColumns[i])].count());
+        for (qsizetype row = 0; row < count; row++)
+            postings[ids.at(row)].append(row);
+    }
+    for (qsizetype row = 0; row < count; row++)
+        chunk->processes[rows.pid.at(row)].append(row);
+}
+
+// Returns the indices of rows ordered by timestamp, rows with equal
+// timestamps in file order. The rows of one thread are nearly always in order
+// already, so they are cut into ascending runs per thread and the runs are
+// merged through a heap, which is O(n log k) for k runs.
+QList<quint32> GStreamerLogModel::Private::sort(const Rows &rows) const
+{
+    const auto &timestamps = rows.timestamp;
+    const auto &tids = rows.symbols[symbol(TidColumn)];
+    QList<QList<quint32>> runs;
+    QHash<quint32, qsizetype> current;
+    for (qsizetype i = 0; i < rows.count(); i++) {
+        const auto tid = tids.at(i);
+        const auto it = current.constFind(tid);
+        if (it != current.constEnd() && timestamps.at(runs.at(it.value()).last()) <= timestamps.at(i)) {
+            runs[it.value()].append(i);
+        } else {
+            current.insert(tid, runs.count());
+            runs.append(QList<quint32>{quint32(i)});
+        }
+    }
+    if (runs.count() < 2)
+        return runs.value(0);
+
+    struct Cursor {
+        qint64 timestamp;
+        quint32 index;
+        qsizetype run;
+        qsizetype position;
+    };
+    const auto later = [](const Cursor &a, const Cursor &b) {
+        if (a.timestamp != b.timestamp)
+            return a.timestamp > b.timestamp;
+        return a.index > b.index;
+    };
+    QList<Cursor> heap;
+    heap.reserve(runs.count());
+    for (qsizetype i = 0; i < runs.count(); i++) {
+        const auto index = runs.at(i).first();
+        heap.append(Cursor{timestamps.at(index), index, i, 0});
+    }
+    std::make_heap(heap.begin(), heap.end(), later);
+
+    QList<quint32> ret;
+    ret.reserve(rows.count());
+    while (!heap.isEmpty()) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        auto &cursor = heap.last();
+        ret.append(cursor.index);
+        const auto &run = runs.at(cursor.run);
+        if (++cursor.position < run.count()) {
+            cursor.index = run.at(cursor.position);
+            cursor.timestamp = timestamps.at(cursor.index);
+            std::push_heap(heap.begin(), heap.end(), later);
+        } else {
+            heap.removeLast();
+        }
+    }
+    return ret;
+}
+
+quint32 GStreamerLogModel::Private::rowSize()
+{
+    quint32 ret = 0;
+    Rows().forEach([&](const auto &array) {
+        ret += sizeof(typename std::remove_reference_t<decltype(array)>::value_type);
+    });
+    return ret;
+}
+
+// The index of a log lives in the cache directory, named after the path of the log
+QString GStreamerLogModel::Private::indexPath() const
+{
+    const auto key = QCryptographicHash::hash(QFileInfo(fileName).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/index/") + QString::fromLatin1(key.toHex()) + QStringLiteral(".idx");
+}
+
+// Identifies the first end bytes of the log by their head and their tail
+QByteArray GStreamerLogModel::Private::digest(qint64 end) const
+{
+    const qint64 sample = qMin<qint64>(end, 64 << 10);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayView(data, sample));
+    hash.addData(QByteArrayView(data + end - sample, sample));
+    return hash.result();
+}
+
+// Runs in the loader thread. Fills chunk with the rows of the index when the
+// index matches the beginning of the log: the size and mtime are the same, or
+// the log grew and the bytes the index was built from are unchanged. Rows
+// after chunk->end still have to be parsed.
+bool GStreamerLogModel::Private::readIndex(Chunk *chunk, qint64 end)
+{
+    QFile file(indexPath());
+    if (!file.open(QIODevice::ReadOnly) || file.size() < qint64(sizeof(IndexHeader)))
+        return false;
+    const auto index = file.map(0, file.size());
+    if (!index)
+        return false;
+    auto cleanup = qScopeGuard([&] {
+        file.unmap(index);
+    });
+
+    IndexHeader header;
+    std::memcpy(&header, index, sizeof(header));
+    if (std::memcmp(header.magic, IndexMagic, sizeof(header.magic)) != 0
+            || header.version != IndexVersion
+            || header.rowSize != rowSize()
+            || header.size <= 0 || header.size > end
+            || header.count < 0 || header.count > std::numeric_limits<quint32>::max()
+            || file.size() < qint64(sizeof(header) + header.count * (rowSize() + sizeof(quint32))))
+        return false;
+    const bool unchanged = header.size == size && header.modified == QFileInfo(fileName).lastModified().toMSecsSinceEpoch();
+    // the last line of the index may have grown since it was written
+    if (!unchanged && (data[header.size - 1] != '\n' || digest(header.size) != QByteArrayView(header.digest, sizeof(header.digest))))
+        return false;
+
+    const uchar *p = index + sizeof(header);
+    chunk->begin = 0;
+    chunk->end = header.size;
+    chunk->lines = header.lines;
+    chunk->rows.forEach([&](auto &array) {
+        array.resize(header.count);
+        std::memcpy(array.data(), p, header.count * sizeof(array.at(0)));
+        p += header.count * sizeof(array.at(0));
+    });
+    chunk->order.resize(header.count);
+    std::memcpy(chunk->order.data(), p, header.count * sizeof(quint32));
+    p += header.count * sizeof(quint32);
+
+    // each string table as a count followed by length prefixed values
+    const uchar *last = index + file.size();
+    auto read = [&](quint32 *value) {
+        if (last - p < qint64(sizeof(quint32)))
+            return false;
+        std::memcpy(value, p, sizeof(quint32));
+        p += sizeof(quint32);
+        return true;
+    };
+    for (auto &values : chunk->symbols) {
+        quint32 count;
+        if (!read(&count))
+            return false;
+        for (quint32 i = 0; i < count; i++) {
+            quint32 length;
+            if (!read(&length) || last - p < qint64(length))
+                return false;
+            values.append(QByteArray(reinterpret_cast<const char *>(p), length));
+            p += length;
+        }
+    }
+
+    // every record is checked, a damaged index is parsed over instead
+    if (header.lines < 0 || header.lines > std::numeric_limits<int>::max())
+        return false;
+    const auto &rows = chunk->rows;
+    for (qsizetype i = 0; i < header.count; i++) {
+        if (canceled.load(std::memory_order_relaxed)
+                || rows.offset.at(i) < 0 || rows.offset.at(i) + rows.length.at(i) > header.size
+                || rows.message.at(i) > rows.length.at(i) || rows.timestampEnd.at(i) > rows.length.at(i)
+                || rows.level.at(i) >= LevelCount
+                || chunk->order.at(i) >= header.count)
+            return false;
+        for (int j = 0; j < SymbolCount; j++) {
+            if (qsizetype(rows.symbols[j].at(i)) >= chunk->symbols[j].count())
+                return false;
+        }
+    }
+    post(chunk);
+    return true;
+}
+
+// Saves the rows loaded so far in the background, replacing any older index
+void GStreamerLogModel::Private::writeIndex()
+{
+    IndexHeader header = {};
+    std::memcpy(header.magic, IndexMagic, sizeof(header.magic));
+    header.version = IndexVersion;
+    header.rowSize = rowSize();
+    header.size = loaded;
+    header.modified = loaded == size ? QFileInfo(fileName).lastModified().toMSecsSinceEpoch() : 0;
+    header.lines = lines;
+    header.count = store.count();
+    const auto hash = digest(loaded);
+    std::memcpy(header.digest, hash.constData(), sizeof(header.digest));
+    indexed = loaded;
+
+    writer.waitForFinished();
+    std::array<QList<QByteArray>, SymbolCount> symbols;
+    for (int i = 0; i < SymbolCount; i++)
+        symbols[i] = store.strings[i].values();
+    writer = QtConcurrent::run([path = indexPath(), header, rows = store.rows, order = store.order, symbols]() {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << file.errorString();
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        rows.forEach([&](const auto &array) {
+            file.write(reinterpret_cast<const char *>(array.constData()), array.count() * sizeof(array.at(0)));
+        });
+        file.write(reinterpret_cast<const char *>(order.constData()), order.count() * sizeof(quint32));
+        for (const auto &values : symbols) {
+            const quint32 count = values.count();
+            file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+            for (const auto &value : values) {
+                const quint32 length = value.size();
+                file.write(reinterpret_cast<const char *>(&length), sizeof(length));
+                file.write(value);
+            }
+        }
+        if (!file.commit())
+            qWarning() << file.errorString();
+    });
+}
+
+void GStreamerLogModel::Private::start(qint64 begin, qint64 end)
+{
+    canceled = false;
+    parsed = false;
+    loader = QThread::create([this, begin, end]() {
+        load(begin, end);
+    });
+    loader->start();
+}
+
+// Runs in the loader thread. Chunks are parsed on the global thread pool, a
+// few at a time, and handed over to the model strictly in file order. A load
+// from the start of the file takes what it can from the index first.
+void GStreamerLogModel::Private::load(qint64 begin, qint64 end)
+{
+    if (begin == 0 && indexing) {
+        Chunk chunk;
+        if (readIndex(&chunk, end)) {
+            begin = chunk.end;
+            QMutexLocker locker(&mutex);
+            indexed = chunk.end;
+            pending.append(chunk);
+        }
+        if (canceled)
+            return;
+        QMetaObject::invokeMethod(q, [this]() { publish(); }, Qt::QueuedConnection);
+    }
+
+    const auto chunks = split(begin, end);
+    const qsizetype window = qMax(2, QThread::idealThreadCount() * 2);
+    QList<QFuture<Chunk>> running;
+    qsizetype next = 0;
+    for (qsizetype i = 0; i < chunks.count() && !canceled; i++) {
+        for (; next < chunks.count() && next - i < window; next++) {
+            running.append(QtConcurrent::run([this, range = chunks.at(next)]() {
+                Chunk chunk = range;
+                parse(&chunk);
+                return chunk;
+            }));
+        }
+        auto chunk = running.takeFirst().result();
+        if (canceled)
+            break;
+        {
+            QMutexLocker locker(&mutex);
+            pending.append(chunk);
+        }
+        QMetaObject::invokeMethod(q, [this]() { publish(); }, Qt::QueuedConnection);
+    }
+    // the workers read the mapping, so they have to be done before returning
+    for (auto &future : running)
+        future.waitForFinished();
+
+    {
+        QMutexLocker locker(&mutex);
+        parsed = true;
+    }
+    QMetaObject::invokeMethod(q, [this]() { publish(); }, Qt::QueuedConnection);
+}
+
+void GStreamerLogModel::Private::stop()
+{
+    if (!loader)
+        return;
+    canceled = true;
+    loader->wait();
+    delete loader;
+    loader = nullptr;
+    pending.clear();
+}
+
+// Moves parsed chunks into the model. Inserting rows lets the views and the
+// proxy run arbitrary code, so nested calls and calls while suspended leave
+// the chunks queued for later.
+void GStreamerLogModel::Private::publish()
+{
+    if (!loader || suspended || publishing)
+        return;
+    publishing = true;
+    // inserting may suspend the model, the rest waits then
+    while (!suspended) {
+        Chunk chunk;
+        {
+            QMutexLocker locker(&mutex);
+            if (pending.isEmpty())
+                break;
+            chunk = pending.takeFirst();
+        }
+        insert(chunk);
+        if (!tail)
+            emit q->loadProgressChanged(chunk.end, size);
+    }
+    publishing = false;
+
+    bool done;
+    {
+        QMutexLocker locker(&mutex);
+        done = parsed && pending.isEmpty();
+    }
+    if (done) {
+        stop();
+        if (tail) {
+            tail = false;
+        } else {
+            if (indexing && loaded != indexed)
+                writeIndex();
+            emit q->loadingChanged(false);
+        }
+        // pick up whatever was appended in the meantime
+        if (following)
+            poll.start();
+        buildTrigrams();
+    }
+}
+
+// Rows of a chunk are later in the file than every row in the model, so each
+// of them goes after the rows with the same timestamp. Logs are nearly sorted,
+// so most chunks end up as a single block appended at the end; otherwise the
+// rows are inserted as contiguous blocks starting from the last one.
+void GStreamerLogModel::Private::insert(Chunk &chunk)
+{
+    const quint32 base = store.count();
+    // ids of the chunk's values in the store's string tables
+    for (int i = 0; i < SymbolCount; i++) {
+        QList<quint32> ids;
+        ids.reserve(chunk.symbols[i].count());
+        for (const auto &value : std::as_const(chunk.symbols[i]))
+            ids.append(store.strings[i].insert(value));
+        for (auto &id : chunk.rows.symbols[i])
+            id = ids.at(id);
+
+        const auto posted = GStreamerLogStore::posted(SymbolColumns[i]);
+        if (posted < 0)
+            continue;
+        auto &postings = store.postings[posted];
+        postings.resize(store.strings[i].count());
+        for (qsizetype local = 0; local < ids.count(); local++) {
+            auto &rows = postings[ids.at(local)];
+            for (const auto row : std::as_const(chunk.postings[posted].at(local)))
+                rows.append(base + row);
+        }
+    }
+    for (auto it = chunk.processes.cbegin(); it != chunk.processes.cend(); ++it) {
+        auto &rows = store.processes[it.key()];
+        for (const auto row : it.value())
+            rows.append(base + row);
+    }
+    for (auto &id : chunk.rows.id)
+        id += lines;
+    lines += chunk.lines;
+    loaded = chunk.end;
+    unterminated = chunk.end > chunk.begin && data[chunk.end - 1] != '\n' ? complete(chunk.begin, chunk.end) : -1;
+    store.rows.append(chunk.rows);
+    updateColors(chunk);
+
+    auto &order = store.order;
+    const auto &timestamps = store.rows.timestamp;
+    auto timestamp = [&](quint32 index) {
+        return timestamps.at(index);
+    };
+    qsizetype position = order.count();
+    qsizetype last = chunk.order.count();
+    while (last > 0) {
+        const auto latest = timestamp(base + chunk.order.at(last - 1));
+        while (position > 0 && timestamp(order.at(position - 1)) > latest)
+            position--;
+        qsizetype first = last - 1;
+        while (first > 0 && (position == 0 || timestamp(base + chunk.order.at(first - 1)) >= timestamp(order.at(position - 1))))
+            first--;
+
+        q->beginInsertRows(QModelIndex(), position, position + last - first - 1);
+        order.insert(position, last - first, 0);
+        for (auto i = first; i < last; i++)
+            order[position + i - first] = base + chunk.order.at(i);
+        q->endInsertRows();
+        last = first;
+    }
+}
+
+// Takes back the last line, which had no newline yet, so that it can be parsed
+// again with what was appended to it. Its row, if it made one, is the last
+// of the store, and the last of its lists.
+void GStreamerLogModel::Private::unloadLast()
+{
+    const auto row = store.count() - 1;
+    if (row >= 0 && store.rows.offset.at(row) == unterminated) {
+        const auto position = store.order.lastIndexOf(quint32(row));
+        q->beginRemoveRows(QModelIndex(), position, position);
+        store.order.remove(position);
+        for (int i = 0; i < GStreamerLogStore::PostedCount; i++)
+            store.postings[i][store.rows.symbols[symbol(GStreamerLogStore::PostedColumns[i])].at(row)].removeLast();
+        const auto pid = store.rows.pid.at(row);
+        store.processes[pid].removeLast();
+        if (store.processes.value(pid).isEmpty())
+            store.processes.remove(pid);
+        store.rows.removeLast();
+        q->endRemoveRows();
+    }
+    lines--;
+    loaded = unterminated;
+    unterminated = -1;
+}
+
+void GStreamerLogModel::Private::updateColors(const Chunk &chunk)
+{
+    bool changed = false;
+    for (auto it = chunk.processes.cbegin(); it != chunk.processes.cend(); ++it) {
+        const auto pid = it.key();
+        if (!processColorMap.contains(pid)) {
+            processColorMap.insert(pid, QColor());
+            changed = true;
+        }
+    }
+    const auto threads = store.strings[symbol(TidColumn)].count();
+    if (threadColors.count() != threads) {
+        threadColors.resize(threads);
+        changed = true;
+    }
+    if (!changed)
+        return;
+
+    const auto pids = processColorMap.keys();
+    for (int i = 0; i < pids.count(); i++) {
+        processColorMap[pids[i]] = QColor::fromHsvF((qreal)i / pids.count() * 0.4, 1, 1, 0.25);
+    }
+    for (int i = 0; i < threads; i++) {
+        threadColors[i] = QColor::fromHsvF((qreal)i / threads * 0.4 + 0.5, 1, 1, 0.25);
+    }
+    if (!store.order.isEmpty())
+        emit q->dataChanged(q->index(0, PidColumn), q->index(store.order.count() - 1, TidColumn), {Qt::BackgroundRole});
+}
+
+// Parses what was appended to the file since the last load. Rows of the tail
+// are inserted like the chunks of a normal load, so the views and the proxy
+// only see new rows. A line without a newline at the end is only taken once
+// the file kept its size for a poll, and parsed again when more of it comes.
+// A file that got shorter was truncated, one that starts differently was
+// replaced, and either is loaded again from the start. While suspended the
+// proxy's threads read the mapping, so it is left alone until
+// setSuspended(false) comes back here.
+void GStreamerLogModel::Private::follow()
+{
+    if (!following || loader || suspended)
+        return;
+    const QFileInfo fileInfo(fileName);
+    if (!fileInfo.exists()) {
+        // removed or being rotated, look again later
+        poll.start(1000);
+        return;
+    }
+    // the watch is dropped when the file is replaced, and not every file
+    // system can be watched; fall back to polling then
+    if (!watcher.files().contains(fileName) && !watcher.addPath(fileName))
+        poll.start(1000);
+    else
+        poll.setInterval(100);
+    if (fileInfo.size() < loaded || isReplaced() || !map() || size < loaded) {
+        q->reload();
+        return;
+    }
+    // the last line again if it grew
+    const auto begin = unterminated >= 0 && size > loaded ? unterminated : loaded;
+    auto end = complete(begin, size);
+    if (end < size) {
+        if (size == settled) {
+            end = size;
+        } else {
+            // still being written, unless it is the same at the next poll
+            settled = size;
+            poll.start();
+        }
+    }
+    if (end <= begin) {
+        buildTrigrams();
+        return;
+    }
+    // the tail changes the store the builder reads, publish() restarts it
+    stopTrigrams();
+    if (begin < loaded)
+        unloadLast();
+    tail = true;
+    start(begin, end);
+}
+
+// Indexes the rows the trigram index does not cover yet, as far as the
+// budget set in the preferences goes. The builder only reads the store and the
+// mapping: whatever changes either stops it first.
+void GStreamerLogModel::Private::buildTrigrams()
+{
+    const auto &trigrams = store.trigrams;
+    // a row of a line without a newline yet may be parsed again, see unloadLast()
+    auto count = store.count();
+    if (count > 0 && store.rows.offset.at(count - 1) == unterminated)
+        count--;
+    if (trigramBuilder || loader || trigrams.isLimited() || trigrams.size() >= count)
+        return;
+    QSettings settings;
+    settings.beginGroup("Preferences");
+    const auto budget = settings.value(QStringLiteral("textIndexSize"), 256).toLongLong() << 20;
+    if (trigrams.bytes() >= budget)
+        return;
+    trigramCanceled = false;
+    trigramsBuilt = false;
+    trigramBuilder = QThread::create([this, from = trigrams.size(), to = count, budget = budget - trigrams.bytes()]() {
+        auto part = indexTrigrams(from, to, budget);
+        if (trigramCanceled)
+            return;
+        {
+            QMutexLocker locker(&mutex);
+            trigramPart = std::move(part);
+            trigramsBuilt = true;
+        }
+        QMetaObject::invokeMethod(q, [this]() { mergeTrigrams(); }, Qt::QueuedConnection);
+    });
+    trigramBuilder->start();
+}
+
+// Runs in the builder thread. Ranges of rows are indexed on the thread pool a
+// few at a time and joined in order until the next would not fit in budget.
+TrigramIndex GStreamerLogModel::Private::indexTrigrams(qsizetype from, qsizetype to, qsizetype budget) const
+{
+    constexpr qsizetype RangeSize = 64 * 1024;
+    const qsizetype batch = RangeSize * QThread::idealThreadCount();
+    TrigramIndex ret(from);
+    for (auto first = from; first < to && !trigramCanceled; first += batch) {
+        QList<qsizetype> ranges;
+        for (auto begin = first; begin < qMin(first + batch, to); begin += RangeSize)
+            ranges.append(begin);
+        auto parts = QtConcurrent::blockingMapped<QList<TrigramIndex>>(ranges, [this, to](qsizetype begin) {
+            TrigramIndex part(begin);
+            const auto end = qMin(begin + RangeSize, to);
+            for (auto row = begin; row < end && !trigramCanceled; row++)
+                part.add(store.bytes(row, MessageColumn));
+            return part;
+        });
+        if (trigramCanceled)
+            break;
+        for (auto &part : parts) {
+            if (ret.bytes() + part.bytes() > budget) {
+                ret.limit();
+                return ret;
+            }
+            ret.append(std::move(part));
+        }
+    }
+    return ret;
+}
+
+void GStreamerLogModel::Private::mergeTrigrams()
+{
+    TrigramIndex part;
+    {
+        QMutexLocker locker(&mutex);
+        // left over from a builder that was stopped
+        if (!trigramBuilder || !trigramsBuilt)
+            return;
+        part = std::move(trigramPart);
+    }
+    stopTrigrams();
+    store.trigrams.append(std::move(part));
+    emit q->textIndexSizeChanged(store.trigrams.bytes());
+}
+
+void GStreamerLogModel::Private::stopTrigrams()
+{
+    if (!trigramBuilder)
+        return;
+    trigramCanceled = true;
+    trigramBuilder->wait();
+    delete trigramBuilder;
+    trigramBuilder = nullptr;
+    trigramsBuilt = false;
+    trigramPart = TrigramIndex();
+}
 
 GStreamerLogModel::GStreamerLogModel(const QString &fileName, QObject *parent)
     : QAbstractTableModel(parent)
-    , d(new Private{fileName})
+    , d(new Private(fileName, this))
 {
     reload();
 }
 
 GStreamerLogModel::~GStreamerLogModel() = default;
 
+int GStreamerLogModel::column(QStringView name)
+{
+    for (int i = 0; i < ColumnCount; i++) {
+        if (name == QLatin1String(Columns[i].name))
+            return i;
+    }
+    return -1;
+}
+
+GStreamerLogModel::Level GStreamerLogModel::level(QByteArrayView name)
+{
+    // as gst_debug_level_get_name() prints them, in GstDebugLevel order
+    static constexpr const char *names[] = { "ERROR", "WARN", "FIXME", "INFO", "DEBUG", "LOG", "TRACE", "MEMDUMP" };
+    for (int i = 0; i < int(std::size(names)); i++) {
+        if (name == names[i])
+            return Level(ErrorLevel + i);
+    }
+    return UnknownLevel;
+}
+
 int GStreamerLogModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
         return 0;
 
-    return d->lines.count();
+    return d->store.order.count();
 }
 
 int GStreamerLogModel::columnCount(const QModelIndex &parent) const
@@ -41,7 +960,7 @@ int GStreamerLogModel::columnCount(const QModelIndex &parent) const
     if (parent.isValid())
         return 0;
 
-    return d->mo->propertyCount();
+    return ColumnCount;
 }
 
 QVariant GStreamerLogModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -49,10 +968,9 @@ QVariant GStreamerLogModel::headerData(int section, Qt::Orientation orientation,
     QVariant ret;
     if (orientation != Qt::Horizontal)
         return ret;
-    const auto mp = d->mo->property(section);
     switch (role) {
     case Qt::DisplayRole:
-        ret = mp.name();
+        ret = QString::fromLatin1(Columns[section].name);
         break;
     case Qt::TextAlignmentRole:
         ret = Qt::AlignLeft;
@@ -65,68 +983,69 @@ QVariant GStreamerLogModel::headerData(int section, Qt::Orientation orientation,
 
 QVariant GStreamerLogModel::data(const QModelIndex &index, int role) const
 {
-    static const auto foregroundColors = QHash<QString, QColor> {
-        // { "WARN", QColor(Qt::white) },
-        { "ERROR", QColor(Qt::yellow) },
+    // by Level
+    static const QVariant foregroundColors[LevelCount] = {
+        QVariant(),
+        QColor(Qt::yellow),
+        // QColor(Qt::white),
     };
 
-    static const auto backgroundColors = QHash<QString, QColor> {
-        { "WARN", QColor(Qt::yellow) },
-        { "ERROR", QColor(Qt::darkRed) },
+    static const QVariant backgroundColors[LevelCount] = {
+        QVariant(),
+        QColor(Qt::darkRed),
+        QColor(Qt::yellow),
     };
 
     QVariant ret;
     if (!index.isValid())
         return ret;
     const auto column = index.column();
-    const auto mp = d->mo->property(column);
-    const auto row = index.row();
-    const auto line = d->lines.at(row);
+    const auto &store = d->store;
+    const auto &rows = store.rows;
+    const auto row = store.order.at(index.row());
     switch (role) {
     case Qt::DisplayRole:
-        ret = mp.readOnGadget(&line);
-        switch (mp.typeId()) {
-        case QMetaType::QString:
-        case QMetaType::Int:
+        switch (column) {
+        case PidColumn:
+            ret = rows.pid.at(row);
+            break;
+        case LineColumn:
+            ret = rows.line.at(row);
             break;
         default:
-            if (mp.typeId() == Timestamp::metaTypeId) {
-                ret = ret.value<Timestamp>().toString();
-            } else {
-                qWarning() << mp.typeId() << "not supported";
-            }
+            ret = store.text(row, column);
             break;
         }
         break;
     case Qt::TextAlignmentRole:
-        if (mp.typeId() == QMetaType::Int || mp.typeId() == QMetaType::Double)
+        if (Columns[column].type == NumberType)
             ret = Qt::AlignRight;
         else
             ret = Qt::AlignLeft;
         break;
     case Qt::ForegroundRole:
-        if (foregroundColors.contains(line.level))
-            ret = foregroundColors.value(line.level);
+        ret = foregroundColors[rows.level.at(row)];
         break;
     case Qt::BackgroundRole:
         switch (column) {
         case PidColumn:
-            if (d->processColorMap.contains(line.pid))
-                ret = d->processColorMap.value(line.pid);
+            if (d->processColorMap.contains(rows.pid.at(row)))
+                ret = d->processColorMap.value(rows.pid.at(row));
             break;
         case TidColumn:
-            if (d->threadColorMap.contains(line.tid))
-                ret = d->threadColorMap.value(line.tid);
+            ret = d->threadColors.value(rows.symbols[Private::symbol(TidColumn)].at(row));
             break;
         default:
-            if (backgroundColors.contains(line.level))
-                ret = backgroundColors.value(line.level);
+            ret = backgroundColors[rows.level.at(row)];
             break;
         }
 
         break;
     case Qt::UserRole:
-        ret = line.id;
+        ret = rows.id.at(row);
+        break;
+    case TimestampRole:
+        ret = QVariant::fromValue(Timestamp::fromNSecs(rows.timestamp.at(row)));
         break;
     default:
         // ret = QAbstractTableModel::data(index, role);
@@ -135,74 +1054,101 @@ QVariant GStreamerLogModel::data(const QModelIndex &index, int role) const
     return ret;
 }
 
-void GStreamerLogModel::reload()
+const GStreamerLogStore &GStreamerLogModel::store() const
 {
-    if (!d->lines.isEmpty()) {
-        beginRemoveRows(QModelIndex(), 0, d->lines.count() - 1);
-        d->lines.clear();
-        endRemoveRows();
+    return d->store;
+}
+
+bool GStreamerLogModel::isLoading() const
+{
+    return d->loader != nullptr && !d->tail;
+}
+
+bool GStreamerLogModel::isFollowing() const
+{
+    return d->following;
+}
+
+void GStreamerLogModel::setFollowing(bool following)
+{
+    if (d->following == following) return;
+    d->following = following;
+    if (following) {
+        d->watcher.addPath(d->fileName);
+        d->poll.start();
+    } else {
+        d->watcher.removePath(d->fileName);
+        d->poll.stop();
     }
+    emit followingChanged(following);
+}
 
-    QFile file(d->fileName);
-    if (!file.open(QIODevice::ReadOnly))
-        return;
+qint64 GStreamerLogModel::textIndexSize() const
+{
+    return d->store.trigrams.bytes();
+}
 
-    QTextStream in(&file);
-    int l = 0;
-    static const QRegularExpression re("^([\\d\\.:]+)\\s+(\\d+)\\s+(0x[0-9a-f]+)\\s+([A-Z]+)\\s+([^\\s]*)\\s+([a-z0-9_\\-\\.]*):(\\d+):([^:]*):(\\s*[^\\s]*)\\s+(.+)$");
-    while (!in.atEnd()) {
-        l++;
-        QString line = in.readLine();
-        QRegularExpressionMatch match = re.match(line);
-        if (match.hasMatch()) {
-            GStreamerLogLine logLine;
-            logLine.id = l;
-            for (int i = 0; i < d->mo->propertyCount(); i++) {
-                const auto mp = d->mo->property(i);
-                const auto text = match.captured(i + 1);
-                QVariant value = text;
-                switch (mp.typeId()) {
-                case QMetaType::QString:
-                    break;
-                case QMetaType::Int:
-                    value = text.toInt();
-                    break;
-                default:
-                    if (mp.typeId() == Timestamp::metaTypeId) {
-                        value = QVariant::fromValue(Timestamp::fromString(text));
-                    } else {
-                        qWarning() << mp.typeId() << "not supported";
-                    }
-                    break;
-                }
-                mp.writeOnGadget(&logLine, value);
-            }
-            d->processColorMap[logLine.pid] = QColor();
-            d->threadColorMap[logLine.tid] = QColor();
-            if (d->lines.isEmpty()) {
-                d->lines.append(logLine);
-            } else {
-                auto timestamp = logLine.timestamp;
-                for (auto i = d->lines.count() - 1; i >= 0; i--) {
-                    if (timestamp > d->lines.at(i).timestamp) {
-                        d->lines.insert(i + 1, logLine);
-                        break;
-                    }
-                }
-            }
-        } else {
-            qWarning() << line;
-        }
+bool GStreamerLogModel::isSuspended() const
+{
+    return d->suspended;
+}
+
+void GStreamerLogModel::setSuspended(bool suspended)
+{
+    if (d->suspended == suspended) return;
+    d->suspended = suspended;
+    emit suspendedChanged(suspended);
+    if (!suspended) {
+        d->publish();
+        // whatever was appended while suspended
+        if (d->following)
+            d->poll.start();
     }
+}
 
-    const auto pids = d->processColorMap.keys();
-    for (int i = 0; i < pids.count(); i++) {
-        d->processColorMap[pids[i]] = QColor::fromHsvF((qreal)i / pids.count() * 0.4, 1, 1, 0.25);
+void GStreamerLogModel::reload()
+{
+    const bool loading = isLoading();
+    d->stopTrigrams();
+    d->stop();
+    d->tail = false;
+    if (!d->store.order.isEmpty()) {
+        beginRemoveRows(QModelIndex(), 0, d->store.order.count() - 1);
+        d->store.order.clear();
+        endRemoveRows();
     }
-    const auto tids = d->threadColorMap.keys();
-    for (int i = 0; i < tids.count(); i++) {
-        d->threadColorMap[tids[i]] = QColor::fromHsvF((qreal)i / tids.count() * 0.4 + 0.5, 1, 1, 0.25);
+    d->store.clear();
+    d->lines = 0;
+    d->loaded = 0;
+    d->unterminated = -1;
+    d->settled = -1;
+    d->indexed = 0;
+    d->processColorMap.clear();
+    d->threadColors.clear();
+    emit textIndexSizeChanged(0);
+
+    QSettings settings;
+    settings.beginGroup("Preferences");
+    d->indexing = settings.value(QStringLiteral("indexFiles"), false).toBool();
+
+    d->unmap();
+    if (d->map()) {
+        // While following, a last line without a newline may still be
+        // written to and is left for follow() to take once it settled.
+        d->start(0, d->following ? d->complete(0, d->size) : d->size);
     }
-    beginInsertRows(QModelIndex(), 0, d->lines.count() - 1);
-    endInsertRows();
+    if (isLoading() != loading)
+        emit loadingChanged(isLoading());
+}
+
+void GStreamerLogModel::cancel()
+{
+    if (!isLoading())
+        return;
+    d->stop();
+    emit loadingChanged(false);
+    // stop following too, otherwise the rest of the file comes back as a tail
+    setFollowing(false);
+    // what was loaded is there to stay
+    d->buildTrigrams();
 }
@@ -2,39 +2,19 @@
 #define GSTREAMERLOGMODEL_H
 
 #include <QtCore/QAbstractTableModel>
-#include "timestamp.h"
 
-class GStreamerLogLine
-{
-    Q_GADGET
-    Q_PROPERTY(Timestamp Timestamp MEMBER timestamp)
-    Q_PROPERTY(int Process MEMBER pid)
-    Q_PROPERTY(QString Thread MEMBER tid)
-    Q_PROPERTY(QString Level MEMBER level)
-    Q_PROPERTY(QString Category MEMBER category)
-    Q_PROPERTY(QString Source MEMBER source)
-    Q_PROPERTY(int Line MEMBER line)
-    Q_PROPERTY(QString Function MEMBER function)
-    Q_PROPERTY(QString Object MEMBER object)
-    Q_PROPERTY(QString Message MEMBER message)
+#include <iterator>
 
-public:
-    int id;
-    Timestamp timestamp;
-    int pid;
-    QString tid;
-    QString level;
-    QString category;
-    QString source;
-    int line;
-    QString function;
-    QString object;
-    QString message;
-};
+class GStreamerLogStore;
 
 class GStreamerLogModel : public QAbstractTableModel
 {
     Q_OBJECT
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged FINAL)
+    Q_PROPERTY(bool suspended READ isSuspended WRITE setSuspended NOTIFY suspendedChanged FINAL)
+    Q_PROPERTY(bool following READ isFollowing WRITE setFollowing NOTIFY followingChanged FINAL)
+    // memory taken by the trigram index of the messages, in bytes
+    Q_PROPERTY(qint64 textIndexSize READ textIndexSize NOTIFY textIndexSizeChanged FINAL)
 public:
     enum Column {
         TimestampColumn,
@@ -48,6 +28,51 @@ public:
         ObjectColumn,
         MessageColumn,
     };
+    enum Role {
+        // the Timestamp of the row in any column, without going through its text
+        TimestampRole = Qt::UserRole + 1,
+    };
+    enum ColumnType {
+        TimestampType,
+        NumberType,
+        TextType,
+    };
+    struct ColumnInfo {
+        const char *name;
+        ColumnType type;
+    };
+    // Names are what the header shows and what Column:keyword filters use
+    static constexpr ColumnInfo Columns[] = {
+        { "Timestamp", TimestampType },
+        { "Process", NumberType },
+        { "Thread", TextType },
+        { "Level", TextType },
+        { "Category", TextType },
+        { "Source", TextType },
+        { "Line", NumberType },
+        { "Function", TextType },
+        { "Object", TextType },
+        { "Message", TextType },
+    };
+    static constexpr int ColumnCount = std::size(Columns);
+    // -1 if there is no column of that name
+    static int column(QStringView name);
+
+    // GstDebugLevel, UnknownLevel for anything else
+    enum Level : quint8 {
+        UnknownLevel,
+        ErrorLevel,
+        WarningLevel,
+        FixmeLevel,
+        InfoLevel,
+        DebugLevel,
+        LogLevel,
+        TraceLevel,
+        MemdumpLevel,
+        LevelCount,
+    };
+    static Level level(QByteArrayView name);
+
     explicit GStreamerLogModel(const QString &fileName, QObject *parent = nullptr);
     ~GStreamerLogModel() override;
 
@@ -57,8 +82,29 @@ public:
     QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+    // The rows behind the model, for code that scans whole columns. Row i of
+    // the model is row store().order[i] of the store.
+    const GStreamerLogStore &store() const;
+
+    bool isLoading() const;
+    // While suspended, parsed rows are kept back instead of being inserted
+    bool isSuspended() const;
+    // While following, data appended to the file is parsed and added as rows
+    bool isFollowing() const;
+    qint64 textIndexSize() const;
+
 public slots:
     void reload();
+    void cancel();
+    void setSuspended(bool suspended);
+    void setFollowing(bool following);
+
+signals:
+    void loadingChanged(bool loading);
+    void loadProgressChanged(qint64 bytesLoaded, qint64 bytesTotal);
+    void suspendedChanged(bool suspended);
+    void followingChanged(bool following);
+    void textIndexSizeChanged(qint64 textIndexSize);
 
 private:
     class Private;
@@ -0,0 +1,74 @@
+#include "gstreamerlogstore.h"
+
+void GStreamerLogStore::Rows::append(const Rows &other)
+{
+    offset.append(other.offset);
+    length.append(other.length);
+    id.append(other.id);
+    timestamp.append(other.timestamp);
+    pid.append(other.pid);
+    line.append(other.line);
+    for (int i = 0; i < SymbolCount; i++)
+        symbols[i].append(other.symbols[i]);
+    level.append(other.level);
+    timestampEnd.append(other.timestampEnd);
+    message.append(other.message);
+}
+
+void GStreamerLogStore::Rows::removeLast()
+{
+    forEach([](auto &array) {
+        array.removeLast();
+    });
+}
+
+void GStreamerLogStore::Rows::clear()
+{
+    forEach([](auto &array) {
+        array.clear();
+    });
+}
+
+QString GStreamerLogStore::text(qsizetype row, int column) const
+{
+    const auto i = symbol(column);
+    if (i >= 0)
+        return strings[i].string(rows.symbols[i].at(row));
+    switch (column) {
+    case GStreamerLogModel::PidColumn:
+        return QString::number(rows.pid.at(row));
+    case GStreamerLogModel::LineColumn:
+        return QString::number(rows.line.at(row));
+    default:
+        return QString::fromUtf8(bytes(row, column));
+    }
+}
+
+QByteArrayView GStreamerLogStore::bytes(qsizetype row, int column) const
+{
+    const auto i = symbol(column);
+    if (i >= 0)
+        return strings[i].values().at(rows.symbols[i].at(row));
+    switch (column) {
+    case GStreamerLogModel::TimestampColumn:
+        return QByteArrayView(data + rows.offset.at(row), rows.timestampEnd.at(row));
+    case GStreamerLogModel::PidColumn:
+    case GStreamerLogModel::LineColumn:
+        return QByteArrayView();
+    default: {
+        const auto message = rows.message.at(row);
+        return QByteArrayView(data + rows.offset.at(row) + message, rows.length.at(row) - message); }
+    }
+}
+
+void GStreamerLogStore::clear()
+{
+    rows.clear();
+    for (auto &table : strings)
+        table.clear();
+    order.clear();
+    for (auto &lists : postings)
+        lists.clear();
+    processes.clear();
+    trigrams.clear();
+}
@@ -0,0 +1,122 @@
+#ifndef GSTREAMERLOGSTORE_H
+#define GSTREAMERLOGSTORE_H
+
+#include "gstreamerlogmodel.h"
+#include "stringtable.h"
+#include "trigramindex.h"
+
+#include <QtCore/QHash>
+
+#include <array>
+#include <iterator>
+
+// The rows of a log, one array per field (struct of arrays) in file order, so
+// scans only touch the fields they look at. Text is not copied: the timestamp
+// and message are byte ranges into the mapped log, the columns with few
+// distinct values are ids into a StringTable each.
+class GStreamerLogStore
+{
+public:
+    static constexpr int SymbolColumns[] = {
+        GStreamerLogModel::TidColumn,
+        GStreamerLogModel::LevelColumn,
+        GStreamerLogModel::CategoryColumn,
+        GStreamerLogModel::SourceColumn,
+        GStreamerLogModel::FunctionColumn,
+        GStreamerLogModel::ObjectColumn,
+    };
+    static constexpr int SymbolCount = std::size(SymbolColumns);
+    // index into symbols and strings for a column, -1 if it is not a symbol column
+    static constexpr int symbol(int column)
+    {
+        for (int i = 0; i < SymbolCount; i++) {
+            if (SymbolColumns[i] == column)
+                return i;
+        }
+        return -1;
+    }
+
+    // symbol columns filters mostly look for a value of, which get posting lists
+    static constexpr int PostedColumns[] = {
+        GStreamerLogModel::TidColumn,
+        GStreamerLogModel::LevelColumn,
+        GStreamerLogModel::CategoryColumn,
+    };
+    static constexpr int PostedCount = std::size(PostedColumns);
+    // index into postings for a column, -1 if it has none
+    static constexpr int posted(int column)
+    {
+        for (int i = 0; i < PostedCount; i++) {
+            if (PostedColumns[i] == column)
+                return i;
+        }
+        return -1;
+    }
+    // rows, ascending, per value
+    using Postings = QList<QList<quint32>>;
+
+    struct Rows
+    {
+        // bytes of the line in the file and its line number
+        QList<qint64> offset;
+        QList<quint32> length;
+        QList<int> id;
+        QList<qint64> timestamp;
+        QList<int> pid;
+        QList<int> line;
+        std::array<QList<quint32>, SymbolCount> symbols;
+        // the level decoded, next to its symbol
+        QList<GStreamerLogModel::Level> level;
+        // the timestamp starts the line, the message runs from here to its end
+        QList<quint32> timestampEnd;
+        QList<quint32> message;
+
+        qsizetype count() const { return offset.count(); }
+        void append(const Rows &other);
+        void removeLast();
+        void clear();
+
+        // Calls function with each array, for code that treats them as raw memory
+        template <typename Function>
+        void forEach(Function function)
+        {
+            function(offset);
+            function(length);
+            function(id);
+            function(timestamp);
+            function(pid);
+            function(line);
+            for (auto &array : symbols)
+                function(array);
+            function(level);
+            function(timestampEnd);
+            function(message);
+        }
+        template <typename Function>
+        void forEach(Function function) const
+        {
+            const_cast<Rows *>(this)->forEach([&](const auto &array) {
+                function(array);
+            });
+        }
+    };
+
+    qsizetype count() const { return rows.count(); }
+    QString text(qsizetype row, int column) const;
+    // the UTF-8 of a column, empty for Process and Line which are numbers
+    QByteArrayView bytes(qsizetype row, int column) const;
+    void clear();
+
+    const char *data = nullptr;
+    Rows rows;
+    std::array<StringTable, SymbolCount> strings;
+    // rows in timestamp order, equal timestamps in file order
+    QList<quint32> order;
+    // the rows of each id of the posted columns, and of each process
+    std::array<Postings, PostedCount> postings;
+    QHash<int, QList<quint32>> processes;
+    // the messages of the rows before trigrams.size(), built once they are loaded
+    TrigramIndex trigrams;
+};
+
+#endif // GSTREAMERLOGSTORE_H
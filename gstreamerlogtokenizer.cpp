@@ -0,0 +1,221 @@
+#include "gstreamerlogtokenizer.h"
+#include "timestamp.h"
+
+#include <QtCore/QRegularExpression>
+
+#include <bit>
+#include <limits>
+
+// SSE2 is part of every x86-64 target; the fields are short enough that
+// wider vectors would mostly scan past them
+#if defined(__SSE2__) || defined(_M_X64)
+#  include <emmintrin.h>
+#  define GLV_TOKENIZER_SSE2
+#endif
+
+namespace {
+
+enum {
+    TimestampField,
+    PidField,
+    TidField,
+    LevelField,
+    CategoryField,
+    SourceField,
+    LineField,
+    FunctionField,
+    ObjectField,
+    MessageField,
+};
+
+// What the scanner is looking for. \s is the ASCII set PCRE uses without UCP.
+enum Delimiter {
+    Space,
+    NotSpace,
+    Colon,
+};
+
+template <Delimiter D>
+inline bool matches(char c)
+{
+    const bool space = c == ' ' || uchar(c) - unsigned('\t') <= unsigned('\r' - '\t');
+    if constexpr (D == Space)
+        return space;
+    else if constexpr (D == NotSpace)
+        return !space;
+    else
+        return c == ':';
+}
+
+#if defined(GLV_TOKENIZER_SSE2)
+using Vector = __m128i;
+constexpr int VectorSize = 16;
+
+inline Vector load(const char *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+inline Vector splat(char c) { return _mm_set1_epi8(c); }
+inline Vector equal(Vector a, Vector b) { return _mm_cmpeq_epi8(a, b); }
+inline Vector either(Vector a, Vector b) { return _mm_or_si128(a, b); }
+inline Vector subtract(Vector a, Vector b) { return _mm_sub_epi8(a, b); }
+inline Vector minimum(Vector a, Vector b) { return _mm_min_epu8(a, b); }
+inline quint32 bits(Vector v) { return quint32(_mm_movemask_epi8(v)); }
+#endif
+
+#if defined(GLV_TOKENIZER_SSE2)
+// one bit per byte of the block that matches the delimiter
+template <Delimiter D>
+inline quint32 mask(Vector v)
+{
+    if constexpr (D == Colon) {
+        return bits(equal(v, splat(':')));
+    } else {
+        // '\t' to '\r' is a single range: c - '\t' <= 4 as an unsigned compare
+        const auto controls = subtract(v, splat('\t'));
+        const auto range = splat('\r' - '\t');
+        const auto space = either(equal(v, splat(' ')), equal(minimum(controls, range), controls));
+        const auto ret = bits(space);
+        if constexpr (D == Space)
+            return ret;
+        else
+            return ~ret & quint32((quint64(1) << VectorSize) - 1);
+    }
+}
+#endif
+
+// first byte in [p, end) that matches the delimiter, end if there is none
+template <Delimiter D>
+inline const char *find(const char *p, const char *end)
+{
+#if defined(GLV_TOKENIZER_SSE2)
+    for (; end - p >= VectorSize; p += VectorSize) {
+        const auto m = mask<D>(load(p));
+        if (m)
+            return p + std::countr_zero(m);
+    }
+#endif
+    for (; p < end; ++p) {
+        if (matches<D>(*p))
+            return p;
+    }
+    return end;
+}
+
+template <typename Predicate>
+inline bool all(const char *p, const char *end, Predicate predicate)
+{
+    for (; p < end; ++p) {
+        if (!predicate(uchar(*p)))
+            return false;
+    }
+    return true;
+}
+
+inline bool isDigit(uchar c) { return c - '0' < 10u; }
+inline bool isLowerHex(uchar c) { return isDigit(c) || c - 'a' < 6u; }
+inline bool isUpper(uchar c) { return c - 'A' < 26u; }
+
+// pid and line are ints, a longer run of digits saturates instead of overflowing
+int parseNumber(QByteArrayView text)
+{
+    constexpr int Max = std::numeric_limits<int>::max();
+    int ret = 0;
+    for (const char c : text) {
+        const int digit = c - '0';
+        if (ret > (Max - digit) / 10)
+            return Max;
+        ret = ret * 10 + digit;
+    }
+    return ret;
+}
+
+}
+
+bool GStreamerLogTokenizer::tokenize(QByteArrayView bytes)
+{
+    text = bytes;
+    if (!scan() && !match())
+        return false;
+
+    timestamp = Timestamp::fromString(field(TimestampField)).toNSecs();
+    pid = parseNumber(field(PidField));
+    line = parseNumber(field(LineField));
+    return true;
+}
+
+// Single left to right pass taking every quantifier greedily, which is the
+// first path the regular expression tries. Whenever that path would need to
+// backtrack, give up and let match() decide.
+bool GStreamerLogTokenizer::scan()
+{
+    const char *const data = text.data();
+    const char *const last = data + text.size();
+    const char *p = data;
+
+    // a run of non-space bytes of one class, followed by at least one space
+    auto word = [&](int index, auto predicate, bool allowEmpty) -> bool {
+        const char *q = find<Space>(p, last);
+        if (q == last || (q == p && !allowEmpty) || !all(p, q, predicate))
+            return false;
+        begin[index] = p - data;
+        end[index] = q - data;
+        p = find<NotSpace>(q, last);
+        return true;
+    };
+
+    // a run of bytes of one class, followed by ':'
+    auto colon = [&](int index, auto predicate, bool allowEmpty) -> bool {
+        const char *q = find<Colon>(p, last);
+        if (q == last || (q == p && !allowEmpty) || !all(p, q, predicate))
+            return false;
+        begin[index] = p - data;
+        end[index] = q - data;
+        p = q + 1;
+        return true;
+    };
+
+    if (!word(TimestampField, [](uchar c) { return isDigit(c) || c == '.' || c == ':'; }, false))
+        return false;
+    if (!word(PidField, isDigit, false))
+        return false;
+    if (last - p < 3 || p[0] != '0' || p[1] != 'x')
+        return false;
+    if (!word(TidField, [](uchar c) { return isLowerHex(c) || c == 'x'; }, false))
+        return false;
+    if (end[TidField] - begin[TidField] < 3 || !all(data + begin[TidField] + 2, data + end[TidField], isLowerHex))
+        return false;
+    if (!word(LevelField, isUpper, false))
+        return false;
+    if (!word(CategoryField, [](uchar) { return true; }, true))
+        return false;
+    if (!colon(SourceField, [](uchar c) { return isDigit(c) || c - 'a' < 26u || c == '_' || c == '-' || c == '.'; }, true))
+        return false;
+    if (!colon(LineField, isDigit, false))
+        return false;
+    if (!colon(FunctionField, [](uchar) { return true; }, true))
+        return false;
+
+    // object: \s*[^\s]* followed by \s+ and a non-empty message
+    const char *objectEnd = find<Space>(find<NotSpace>(p, last), last);
+    const char *message = find<NotSpace>(objectEnd, last);
+    if (objectEnd == last || message == last)
+        return false;
+    begin[ObjectField] = p - data;
+    end[ObjectField] = objectEnd - data;
+    begin[MessageField] = message - data;
+    end[MessageField] = last - data;
+    return true;
+}
+
+bool GStreamerLogTokenizer::match()
+{
+    static const QRegularExpression re("^([\\d\\.:]+)\\s+(\\d+)\\s+(0x[0-9a-f]+)\\s+([A-Z]+)\\s+([^\\s]*)\\s+([a-z0-9_\\-\\.]*):(\\d+):([^:]*):(\\s*[^\\s]*)\\s+(.+)$");
+    // Latin-1 maps every byte to one character, so capture offsets are byte offsets
+    const auto line = QString::fromLatin1(text);
+    const auto match = re.match(line);
+    if (!match.hasMatch())
+        return false;
+    for (int i = 0; i < FieldCount; i++) {
+        begin[i] = match.capturedStart(i + 1);
+        end[i] = match.capturedEnd(i + 1);
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef GSTREAMERLOGTOKENIZER_H
+#define GSTREAMERLOGTOKENIZER_H
+
+#include <QtCore/QByteArrayView>
+
+// Splits one line of GStreamer debug output into its fields. Field indices
+// follow GStreamerLogModel::Column, offsets are in bytes from the start of the
+// line. The result is identical to matching the line against
+//
+//   ^([\d\.:]+)\s+(\d+)\s+(0x[0-9a-f]+)\s+([A-Z]+)\s+([^\s]*)\s+
+//   ([a-z0-9_\-\.]*):(\d+):([^:]*):(\s*[^\s]*)\s+(.+)$
+//
+// which is what the viewer used before. Lines the scanner can not split in a
+// single pass are handed to that regular expression, so odd lines still get
+// the same boundaries.
+class GStreamerLogTokenizer
+{
+public:
+    static constexpr int FieldCount = 10;
+
+    bool tokenize(QByteArrayView line);
+
+    QByteArrayView field(int field) const { return text.sliced(begin[field], end[field] - begin[field]); }
+
+    QByteArrayView text;
+    qsizetype begin[FieldCount] = {};
+    qsizetype end[FieldCount] = {};
+    qint64 timestamp = 0;
+    int pid = 0;
+    int line = 0;
+
+private:
+    friend class TestGStreamerLogTokenizer;
+    bool scan();
+    bool match();
+};
+
+#endif // GSTREAMERLOGTOKENIZER_H
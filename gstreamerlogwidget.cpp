@@ -2,6 +2,9 @@
 #include "ui_gstreamerlogwidget.h"
 #include "gstreamerlogmodel.h"
 #include "customfilterproxymodel.h"
+#include "filterquery.h"
+#include "highlightdelegate.h"
+#include "timestamp.h"
 
 #include <QtCore/QDir>
 #include <QtCore/QProcess>
@@ -9,6 +12,8 @@
 #include <QtCore/QTimer>
 #include <QtGui/QShortcut>
 
+#include <algorithm>
+
 namespace {
 
 QString searchFile(const QDir &directory, const QString &fileName)
@@ -37,14 +42,28 @@ public:
 
 private:
     void open(const QString &fileName, int line) const;
+    void restoreCurrent();
+    void findNext(Qt::KeyboardModifiers modifiers);
 
 private:
     ::GStreamerLogWidget *q;
     QString fileName;
+    // the rows Find hit, until the rows shown change
     struct SearchResults {
         QString text;
-        QModelIndex index;
+        QString needle;
+        QList<int> columns;
+        QList<int> rows;
+        bool valid = false;
+        // while the proxy looks for them, where to go once they are there
+        bool pending = false;
+        Qt::KeyboardModifiers modifiers;
     } searchResults;
+    // where the current index goes once the filter is applied
+    struct Anchor {
+        Timestamp timestamp;
+        int column = -1;
+    } anchor;
 public:
     GStreamerLogModel model;
     CustomFilterProxyModel proxyModel;
@@ -61,6 +80,7 @@ GStreamerLogWidget::Private::Private(const QString &fileName, ::GStreamerLogWidg
     setupUi(q);
 
     tableView->setModel(&proxyModel);
+    tableView->setItemDelegate(new HighlightDelegate(tableView));
     connect(tableView, &GStreamerLogView::jumpToLog, [this](int line) {
         open(this->fileName, line);
     });
@@ -82,7 +102,7 @@ GStreamerLogWidget::Private::Private(const QString &fileName, ::GStreamerLogWidg
         }
     });
 
-    connect(tableView, &GStreamerLogView::activated, [this](const QString &text) {
+    auto activated = [this](const QString &text) {
         auto filterText = filter->text();
         if (filterText.isEmpty()) {
             filterText = text;
@@ -97,19 +117,52 @@ GStreamerLogWidget::Private::Private(const QString &fileName, ::GStreamerLogWidg
         filter->setText(filterText);
         filter->setFocus();
         QTimer::singleShot(100, filter, &QLineEdit::returnPressed);
-    });
+    };
+    connect(tableView, &GStreamerLogView::activated, activated);
+    connect(facetView, &FacetView::activated, activated);
     timestampView->setBuddy(tableView);
+    facetView->setLogModel(&model);
     proxyModel.setSourceModel(&model);
-    connect(&proxyModel, &CustomFilterProxyModel::layoutAboutToBeChanged, [this]() {
-        q->setBusy(true);
+    connect(&model, &GStreamerLogModel::loadingChanged, q, &::GStreamerLogWidget::loadingChanged);
+    connect(&model, &GStreamerLogModel::loadProgressChanged, q, &::GStreamerLogWidget::loadProgressChanged);
+    connect(&model, &GStreamerLogModel::followingChanged, q, &::GStreamerLogWidget::followingChanged);
+    connect(&model, &GStreamerLogModel::textIndexSizeChanged, q, &::GStreamerLogWidget::textIndexSizeChanged);
+    connect(&model, &GStreamerLogModel::rowsInserted, [this]() {
+        emit q->countChanged(model.rowCount());
+    });
+    connect(&model, &GStreamerLogModel::rowsRemoved, [this]() {
+        emit q->countChanged(model.rowCount());
+    });
+    connect(&proxyModel, &CustomFilterProxyModel::rowsInserted, [this]() {
+        emit q->filteredCountChanged(proxyModel.rowCount());
+    });
+    connect(&proxyModel, &CustomFilterProxyModel::rowsRemoved, [this]() {
+        emit q->filteredCountChanged(proxyModel.rowCount());
     });
     connect(&proxyModel, &CustomFilterProxyModel::layoutChanged, [this]() {
         q->filteredCountChanged(proxyModel.rowCount());
-        QTimer::singleShot(10, [this]() {
-            q->setBusy(false);
-        });
+    });
+    auto invalidate = [this]() {
+        if (searchResults.valid)
+            timestampView->setHits(QList<int>(), QList<Timestamp>());
+        // the proxy canceled the find
+        if (searchResults.pending)
+            findCount->clear();
+        searchResults.valid = false;
+        searchResults.pending = false;
+    };
+    connect(&proxyModel, &CustomFilterProxyModel::rowsInserted, invalidate);
+    connect(&proxyModel, &CustomFilterProxyModel::rowsRemoved, invalidate);
+    connect(&proxyModel, &CustomFilterProxyModel::layoutChanged, invalidate);
+    connect(&proxyModel, &CustomFilterProxyModel::modelReset, invalidate);
+    connect(&proxyModel, &CustomFilterProxyModel::filteringChanged, [this](bool filtering) {
+        q->setBusy(filtering);
+        if (!filtering)
+            restoreCurrent();
     });
     connect(&proxyModel, &CustomFilterProxyModel::progressChanged, q, &::GStreamerLogWidget::progressChanged);
+    connect(&proxyModel, &CustomFilterProxyModel::cacheHitRateChanged, q, &::GStreamerLogWidget::filterCacheHitRateChanged);
+    connect(&proxyModel, &CustomFilterProxyModel::filterTimeChanged, q, &::GStreamerLogWidget::filterTimeChanged);
     splitter->restoreState(settings.value(QStringLiteral("splitterState")).toByteArray());
 
     auto shortcut = new QShortcut(QKeySequence(tr("Ctrl+L", "Filter")), q);
@@ -124,44 +177,67 @@ GStreamerLogWidget::Private::Private(const QString &fileName, ::GStreamerLogWidg
         if (currentIndex.row() < firstIndex.row() || lastIndex.row() < currentIndex.row()) {
             currentIndex = currentIndex.siblingAtRow((firstIndex.row() + lastIndex.row()) / 2);
         }
-        const auto timestamp = Timestamp::fromString(currentIndex.siblingAtColumn(GStreamerLogModel::TimestampColumn).data().toString());
+        anchor.timestamp = currentIndex.data(GStreamerLogModel::TimestampRole).value<Timestamp>();
+        anchor.column = currentIndex.column();
+        const auto error = FilterQuery(filter->text()).errorString();
+        if (!error.isEmpty())
+            emit q->errorOccurred(error);
         proxyModel.setFilter(filter->text());
-        const auto indices = proxyModel.match(QModelIndex(), Qt::DisplayRole, QVariant::fromValue(timestamp), 1, Qt::MatchStartsWith); // abuse the flag for nearest timestamp match
-        if (!indices.isEmpty()) {
-            const auto index = indices.first().siblingAtColumn(currentIndex.column());
-            tableView->setCurrentIndex(index);
-            QTimer::singleShot(10, [this]() {
-                tableView->scrollTo(tableView->currentIndex().siblingAtColumn(GStreamerLogModel::TimestampColumn), QTableView::PositionAtCenter);
-            });
-        }
+        // otherwise once the rows are there
+        if (!proxyModel.isFiltering())
+            restoreCurrent();
     });
 
     shortcut = new QShortcut(QKeySequence(tr("Ctrl+F", "Find")), q);
     connect(shortcut, &QShortcut::activated, [this]() {
         find->setFocus();
     });
+    connect(find, &QLineEdit::textChanged, [this]() {
+        proxyModel.cancelFind();
+        searchResults.pending = false;
+        findCount->clear();
+    });
+    connect(&proxyModel, &CustomFilterProxyModel::found, [this](const QList<int> &rows, const QList<Timestamp> &timestamps) {
+        searchResults.rows = rows;
+        searchResults.valid = true;
+        searchResults.pending = false;
+        timestampView->setHits(rows, timestamps);
+        findCount->setText(tr("%n hit(s)", nullptr, rows.count()));
+        findNext(searchResults.modifiers);
+    });
     connect(find, &LineEdit::activated, [this](Qt::KeyboardModifiers modifiers) {
         const auto text = find->text();
-        searchResults.text = text;
-        auto start = searchResults.index;
-        if (!start.isValid() || start != tableView->currentIndex())
-            start = tableView->currentIndex();
-        if (!start.isValid())
-            start = proxyModel.index(0, 0, QModelIndex());
-        q->setBusy(true);
-        Qt::MatchFlags flags = Qt::MatchContains | Qt::MatchWrap;
-        if (modifiers & Qt::ShiftModifier)
-            flags |= Qt::MatchRecursive; // abuse recursive flag for backwards search
-        const auto indices = proxyModel.match(start, Qt::DisplayRole, text, 1, flags);
-        q->setBusy(false);
-        searchResults.index = indices.isEmpty() ? QModelIndex() : indices.first();
-
-        if (!searchResults.index.isValid())
+        searchResults.modifiers = modifiers;
+        if (searchResults.pending && searchResults.text == text)
             return;
-
-        tableView->setCurrentIndex(searchResults.index);
-        tableView->selectionModel()->select(searchResults.index, QItemSelectionModel::ClearAndSelect);
-        tableView->scrollTo(searchResults.index);
+        if (!searchResults.valid || searchResults.text != text) {
+            searchResults.text = text;
+            searchResults.needle = text;
+            searchResults.columns.clear();
+            // Column:text, also Column,Column:text, looks in those columns only
+            const auto colon = text.indexOf(QLatin1Char(':'));
+            if (colon > 0) {
+                for (const auto name : QStringView(text).first(colon).split(QLatin1Char(','))) {
+                    const auto column = GStreamerLogModel::column(name.trimmed());
+                    if (column < 0) {
+                        searchResults.columns.clear();
+                        break;
+                    }
+                    searchResults.columns.append(column);
+                }
+                if (!searchResults.columns.isEmpty())
+                    searchResults.needle = text.mid(colon + 1);
+            }
+            // found() goes on from there
+            if (searchResults.valid)
+                timestampView->setHits(QList<int>(), QList<Timestamp>());
+            searchResults.valid = false;
+            searchResults.pending = true;
+            findCount->setText(tr("Finding..."));
+            proxyModel.findAll(searchResults.needle, searchResults.columns);
+            return;
+        }
+        findNext(modifiers);
     });
 }
 
@@ -170,6 +246,52 @@ GStreamerLogWidget::Private::~Private()
     settings.setValue(QStringLiteral("splitterState"), splitter->saveState());
 }
 
+void GStreamerLogWidget::Private::findNext(Qt::KeyboardModifiers modifiers)
+{
+    const auto &rows = searchResults.rows;
+    if (rows.isEmpty())
+        return;
+    // the next hit after the current row, the one before it with Shift, wrapping around
+    const auto current = tableView->currentIndex().row();
+    QList<int>::const_iterator hit;
+    if (modifiers & Qt::ShiftModifier) {
+        hit = std::lower_bound(rows.cbegin(), rows.cend(), current);
+        hit = hit == rows.cbegin() ? rows.cend() - 1 : hit - 1;
+    } else {
+        hit = std::upper_bound(rows.cbegin(), rows.cend(), current);
+        if (hit == rows.cend())
+            hit = rows.cbegin();
+    }
+
+    auto index = proxyModel.index(*hit, qMax(tableView->currentIndex().column(), 0));
+    for (int column = 0; column < proxyModel.columnCount(); column++) {
+        if (!searchResults.columns.isEmpty() && !searchResults.columns.contains(column))
+            continue;
+        const auto cell = index.siblingAtColumn(column);
+        if (cell.data().toString().contains(searchResults.needle)) {
+            index = cell;
+            break;
+        }
+    }
+    tableView->setCurrentIndex(index);
+    tableView->selectionModel()->select(index, QItemSelectionModel::ClearAndSelect);
+    tableView->scrollTo(index);
+}
+
+void GStreamerLogWidget::Private::restoreCurrent()
+{
+    if (anchor.column < 0)
+        return;
+    const auto column = std::exchange(anchor.column, -1);
+    const auto indices = proxyModel.match(QModelIndex(), Qt::DisplayRole, QVariant::fromValue(anchor.timestamp), 1, Qt::MatchStartsWith); // abuse the flag for nearest timestamp match
+    if (indices.isEmpty())
+        return;
+    tableView->setCurrentIndex(indices.first().siblingAtColumn(column));
+    QTimer::singleShot(10, [this]() {
+        tableView->scrollTo(tableView->currentIndex().siblingAtColumn(GStreamerLogModel::TimestampColumn), QTableView::PositionAtCenter);
+    });
+}
+
 void GStreamerLogWidget::Private::open(const QString &fileName, int line) const
 {
     QSettings settings;
@@ -213,6 +335,21 @@ void GStreamerLogWidget::setBusy(bool busy)
     emit busyChanged(busy);
 }
 
+bool GStreamerLogWidget::isLoading() const
+{
+    return d->model.isLoading();
+}
+
+bool GStreamerLogWidget::isFollowing() const
+{
+    return d->model.isFollowing();
+}
+
+void GStreamerLogWidget::setFollowing(bool following)
+{
+    d->model.setFollowing(following);
+}
+
 int GStreamerLogWidget::count() const
 {
     return d->model.rowCount();
@@ -223,7 +360,27 @@ int GStreamerLogWidget::filteredCount() const
     return d->proxyModel.rowCount();
 }
 
+int GStreamerLogWidget::filterCacheHitRate() const
+{
+    return d->proxyModel.cacheHitRate();
+}
+
+qint64 GStreamerLogWidget::textIndexSize() const
+{
+    return d->model.textIndexSize();
+}
+
+qint64 GStreamerLogWidget::filterTime() const
+{
+    return d->proxyModel.filterTime();
+}
+
 void GStreamerLogWidget::reload()
 {
     d->model.reload();
 }
+
+void GStreamerLogWidget::cancel()
+{
+    d->model.cancel();
+}
@@ -7,24 +7,44 @@ class GStreamerLogWidget : public QWidget
 {
     Q_OBJECT
     Q_PROPERTY(bool busy READ isBusy WRITE setBusy NOTIFY busyChanged FINAL)
-    Q_PROPERTY(int count READ count CONSTANT FINAL)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged FINAL)
+    Q_PROPERTY(bool following READ isFollowing WRITE setFollowing NOTIFY followingChanged FINAL)
+    Q_PROPERTY(int count READ count NOTIFY countChanged FINAL)
     Q_PROPERTY(int filteredCount READ filteredCount NOTIFY filteredCountChanged FINAL)
+    Q_PROPERTY(int filterCacheHitRate READ filterCacheHitRate NOTIFY filterCacheHitRateChanged FINAL)
+    Q_PROPERTY(qint64 textIndexSize READ textIndexSize NOTIFY textIndexSizeChanged FINAL)
+    Q_PROPERTY(qint64 filterTime READ filterTime NOTIFY filterTimeChanged FINAL)
 public:
     explicit GStreamerLogWidget(const QString &fileName, QWidget *parent = nullptr);
     ~GStreamerLogWidget() override;
 
     bool isBusy() const;
+    bool isLoading() const;
+    bool isFollowing() const;
     int count() const;
     int filteredCount() const;
+    int filterCacheHitRate() const;
+    qint64 textIndexSize() const;
+    qint64 filterTime() const;
 
 public slots:
     void setBusy(bool busy);
     void reload();
+    // stops loading, the rows loaded so far stay
+    void cancel();
+    void setFollowing(bool following);
 
 signals:
     void busyChanged(bool busy);
     void progressChanged(int progress); // TODO: make property
+    void loadingChanged(bool loading);
+    void loadProgressChanged(qint64 bytesLoaded, qint64 bytesTotal);
+    void followingChanged(bool following);
+    void countChanged(int count);
     void filteredCountChanged(int count);
+    void filterCacheHitRateChanged(int filterCacheHitRate);
+    void textIndexSizeChanged(qint64 textIndexSize);
+    void filterTimeChanged(qint64 filterTime);
     void openPreferences(const QString &focus);
     void errorOccurred(const QString &message);
 
@@ -0,0 +1,57 @@
+#include "highlightdelegate.h"
+#include "customfilterproxymodel.h"
+#include "filterquery.h"
+
+#include <QtGui/QPainter>
+#include <QtGui/QTextLayout>
+
+#include <QtWidgets/QApplication>
+
+HighlightDelegate::HighlightDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{}
+
+// The cell is drawn by the style without its text, which is then laid out
+// the way QCommonStyle does it, on one line with the matches behind a color.
+void HighlightDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const auto spans = index.data(CustomFilterProxyModel::MatchSpansRole).value<QList<FilterQuery::Span>>();
+    if (spans.isEmpty()) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+    const auto text = std::exchange(opt.text, QString());
+    const auto style = opt.widget ? opt.widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
+
+    const auto margin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, opt.widget) + 1;
+    const auto rect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, opt.widget).adjusted(margin, 0, -margin, 0);
+
+    QTextCharFormat format;
+    format.setBackground(QColor(255, 255, 0, 160));
+    QList<QTextLayout::FormatRange> formats;
+    formats.reserve(spans.count());
+    for (const auto &span : spans)
+        formats.append({ int(span.start), int(span.length), format });
+
+    QTextOption textOption;
+    textOption.setWrapMode(QTextOption::NoWrap);
+    textOption.setAlignment(QStyle::visualAlignment(opt.direction, opt.displayAlignment));
+    QTextLayout layout(text, opt.font);
+    layout.setTextOption(textOption);
+    layout.setFormats(formats);
+    layout.beginLayout();
+    auto line = layout.createLine();
+    line.setLineWidth(rect.width());
+    layout.endLayout();
+
+    const auto group = !(opt.state & QStyle::State_Enabled) ? QPalette::Disabled : (opt.state & QStyle::State_Active) ? QPalette::Normal : QPalette::Inactive;
+    painter->save();
+    painter->setClipRect(rect);
+    painter->setPen(opt.palette.color(group, opt.state & QStyle::State_Selected ? QPalette::HighlightedText : QPalette::Text));
+    layout.draw(painter, QPointF(rect.left(), rect.top() + (rect.height() - line.height()) / 2));
+    painter->restore();
+}
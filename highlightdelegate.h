@@ -0,0 +1,17 @@
+#ifndef HIGHLIGHTDELEGATE_H
+#define HIGHLIGHTDELEGATE_H
+
+#include <QtWidgets/QStyledItemDelegate>
+
+// Paints the text of a cell with what the filter matched in it highlighted,
+// as CustomFilterProxyModel::MatchSpansRole tells
+class HighlightDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit HighlightDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+};
+
+#endif // HIGHLIGHTDELEGATE_H
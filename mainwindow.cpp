@@ -21,6 +21,8 @@ public:
 private:
     void tabCountChanged(int index);
     void openFile(const QString &fileName);
+    void setFilterCacheHitRate(int hitRate);
+    void setTextIndexSize(qint64 size);
 
 private:
     ::MainWindow *q;
@@ -33,7 +35,11 @@ MainWindow::Private::Private(::MainWindow *parent)
     setupUi(q);
     statusbar->addPermanentWidget(progressBar);
     statusbar->addPermanentWidget(counts);
+    statusbar->addPermanentWidget(filterCache);
+    statusbar->addPermanentWidget(textIndex);
     progressBar->setVisible(false);
+    setFilterCacheHitRate(-1);
+    setTextIndexSize(0);
 
     connect(readme, &QTextBrowser::anchorClicked, [](const QUrl &url) {
         QDesktopServices::openUrl(url);
@@ -51,13 +57,27 @@ MainWindow::Private::Private(::MainWindow *parent)
 
     connect(tabWidget, &QTabWidget::currentChanged, [this](int index) {
         QString text;
+        bool loading = false;
+        bool following = false;
+        int hitRate = -1;
+        qint64 indexSize = 0;
         if (index >= 0) {
             auto widget = tabWidget->widget(index);
             auto tableView = qobject_cast<GStreamerLogWidget *>(widget);
-            if (tableView)
+            if (tableView) {
                 text = QStringLiteral("%1/%2").arg(tableView->filteredCount()).arg(tableView->count());
+                loading = tableView->isLoading();
+                following = tableView->isFollowing();
+                hitRate = tableView->filterCacheHitRate();
+                indexSize = tableView->textIndexSize();
+            }
         }
         counts->setText(text);
+        setFilterCacheHitRate(hitRate);
+        setTextIndexSize(indexSize);
+        progressBar->setVisible(loading);
+        stop->setEnabled(loading);
+        follow->setChecked(following);
     });
 
     settings.beginGroup(q->metaObject()->className());
@@ -104,6 +124,14 @@ MainWindow::Private::Private(::MainWindow *parent)
         static_cast<GStreamerLogWidget *>(tabWidget->currentWidget())->reload();
     });
 
+    connect(stop, &QAction::triggered, [this]() {
+        static_cast<GStreamerLogWidget *>(tabWidget->currentWidget())->cancel();
+    });
+
+    connect(follow, &QAction::triggered, [this](bool checked) {
+        static_cast<GStreamerLogWidget *>(tabWidget->currentWidget())->setFollowing(checked);
+    });
+
     connect(preferences, &QAction::triggered, [this]() {
         Preferences dialog(q);
         dialog.exec();
@@ -137,10 +165,23 @@ void MainWindow::Private::tabCountChanged(int index) {
     const bool empty = index < 0;
     readme->setVisible(empty);
     reload->setEnabled(!empty);
+    if (empty)
+        stop->setEnabled(false);
+    follow->setEnabled(!empty);
     close->setEnabled(!empty);
     tabWidget->setVisible(!empty);
 }
 
+void MainWindow::Private::setFilterCacheHitRate(int hitRate) {
+    filterCache->setVisible(hitRate >= 0);
+    filterCache->setText(tr("Filter cache: %1%").arg(hitRate));
+}
+
+void MainWindow::Private::setTextIndexSize(qint64 size) {
+    textIndex->setVisible(size > 0);
+    textIndex->setText(tr("Text index: %1").arg(q->locale().formattedDataSize(size)));
+}
+
 void MainWindow::Private::openFile(const QString &fileName) {
     auto recentFiles = settings.value(QStringLiteral("recentFiles")).toStringList();
     if (recentFiles.contains(fileName))
@@ -165,12 +206,11 @@ void MainWindow::Private::openFile(const QString &fileName) {
         statusbar->showMessage(tr("File does not exist: %1").arg(fileName), 10000);
         return;
     }
-    QGuiApplication::setOverrideCursor(Qt::BusyCursor);
     auto tableView = new GStreamerLogWidget(fileName);
-    QGuiApplication::restoreOverrideCursor();
     connect(tableView, &GStreamerLogWidget::busyChanged, [this](bool busy) {
         progressBar->setVisible(busy);
         progressBar->setMaximum(100);
+        progressBar->resetFormat();
         if (busy)
             QGuiApplication::setOverrideCursor(Qt::BusyCursor);
         else
@@ -183,7 +223,26 @@ void MainWindow::Private::openFile(const QString &fileName) {
             progressBar->setMaximum(100);
             progressBar->setValue(progress);
         }
-        QGuiApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    });
+    connect(tableView, &GStreamerLogWidget::loadingChanged, [tableView, this](bool loading) {
+        if (tabWidget->currentWidget() != tableView)
+            return;
+        progressBar->setVisible(loading);
+        progressBar->resetFormat();
+        stop->setEnabled(loading);
+    });
+    connect(tableView, &GStreamerLogWidget::loadProgressChanged, [tableView, this](qint64 bytesLoaded, qint64 bytesTotal) {
+        if (tabWidget->currentWidget() != tableView)
+            return;
+        progressBar->setVisible(true);
+        progressBar->setMaximum(100);
+        progressBar->setValue(bytesTotal > 0 ? bytesLoaded * 100 / bytesTotal : 0);
+        progressBar->setFormat(QStringLiteral("%1 / %2").arg(q->locale().formattedDataSize(bytesLoaded)).arg(q->locale().formattedDataSize(bytesTotal)));
+    });
+    connect(tableView, &GStreamerLogWidget::followingChanged, [tableView, this](bool following) {
+        if (tabWidget->currentWidget() != tableView)
+            return;
+        follow->setChecked(following);
     });
     connect(tableView, &GStreamerLogWidget::openPreferences, [this](const QString &focus) {
         Preferences dialog(q);
@@ -196,6 +255,21 @@ void MainWindow::Private::openFile(const QString &fileName) {
     connect(tableView, &GStreamerLogWidget::filteredCountChanged, [tableView, this](int count) {
         counts->setText(QStringLiteral("%1/%2").arg(count).arg(tableView->count()));
     });
+    connect(tableView, &GStreamerLogWidget::filterCacheHitRateChanged, [tableView, this](int hitRate) {
+        if (tabWidget->currentWidget() == tableView)
+            setFilterCacheHitRate(hitRate);
+    });
+    connect(tableView, &GStreamerLogWidget::filterTimeChanged, [tableView, this](qint64 filterTime) {
+        if (tabWidget->currentWidget() == tableView)
+            statusbar->showMessage(tr("Filtered %1 lines in %2 ms").arg(tableView->count()).arg(filterTime), 5000);
+    });
+    connect(tableView, &GStreamerLogWidget::textIndexSizeChanged, [tableView, this](qint64 size) {
+        if (tabWidget->currentWidget() == tableView)
+            setTextIndexSize(size);
+    });
+    connect(tableView, &GStreamerLogWidget::countChanged, [tableView, this](int count) {
+        counts->setText(QStringLiteral("%1/%2").arg(tableView->filteredCount()).arg(count));
+    });
     counts->setText(QStringLiteral("%1/%2").arg(tableView->filteredCount()).arg(tableView->count()));
 
     int index = tabWidget->addTab(tableView, fileInfo.fileName());
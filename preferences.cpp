@@ -57,6 +57,9 @@ Preferences::Private::Private(::Preferences *parent)
             });
 
     externalTextEditor->setCurrentText(settings.value(QStringLiteral("externalTextEditor")).toString());
+    indexFiles->setChecked(settings.value(QStringLiteral("indexFiles"), false).toBool());
+    filterCacheSize->setValue(settings.value(QStringLiteral("filterCacheSize"), 64).toInt());
+    textIndexSize->setValue(settings.value(QStringLiteral("textIndexSize"), 256).toInt());
     q->restoreGeometry(settings.value(QStringLiteral("geometry")).toByteArray());
 }
 
@@ -84,5 +87,8 @@ void Preferences::accept()
 {
     d->settings.setValue(QStringLiteral("gstreamerSourceDirectory"), d->gstreamerSourceDirectory->text());
     d->settings.setValue(QStringLiteral("externalTextEditor"), d->externalTextEditor->currentText());
+    d->settings.setValue(QStringLiteral("indexFiles"), d->indexFiles->isChecked());
+    d->settings.setValue(QStringLiteral("filterCacheSize"), d->filterCacheSize->value());
+    d->settings.setValue(QStringLiteral("textIndexSize"), d->textIndexSize->value());
     QDialog::accept();
 }
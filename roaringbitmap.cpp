@@ -0,0 +1,137 @@
+#include "roaringbitmap.h"
+#include "rowbitmap.h"
+
+#include <algorithm>
+#include <bit>
+
+RoaringBitmap::RoaringBitmap(const RowBitmap &bitmap)
+    : bits(bitmap.size())
+    , ones(bitmap.count())
+{
+    const auto words = bitmap.constData();
+    const auto wordCount = (bits + 63) / 64;
+    for (qsizetype first = 0; first < wordCount; first += BlockWords) {
+        const auto last = qMin(first + BlockWords, wordCount);
+        qsizetype count = 0;
+        qsizetype runs = 0;
+        bool previous = false;
+        for (auto w = first; w < last; w++) {
+            const auto word = words[w];
+            count += std::popcount(word);
+            // a run starts at every set bit whose lower neighbour is clear
+            runs += std::popcount(word & ~(word << 1 | quint64(previous)));
+            previous = word >> 63;
+        }
+
+        Container container;
+        const auto arrayBytes = count * 2;
+        const auto runsBytes = runs * 4;
+        const auto bitmapBytes = (last - first) * 8;
+        if (bitmapBytes < arrayBytes && bitmapBytes < runsBytes) {
+            container.kind = Bitmap;
+            container.words.reserve(last - first);
+            for (auto w = first; w < last; w++)
+                container.words.append(words[w]);
+        } else if (runsBytes < arrayBytes) {
+            container.kind = Runs;
+            container.values.reserve(runs * 2);
+            qsizetype start = -1;
+            for (auto w = first; w < last; w++) {
+                for (int bit = 0; bit < 64; bit++) {
+                    const bool set = words[w] >> bit & 1;
+                    const auto row = (w - first) * 64 + bit;
+                    if (set && start < 0) {
+                        start = row;
+                    } else if (!set && start >= 0) {
+                        container.values.append(quint16(start));
+                        container.values.append(quint16(row - 1));
+                        start = -1;
+                    }
+                }
+            }
+            if (start >= 0) {
+                container.values.append(quint16(start));
+                container.values.append(quint16((last - first) * 64 - 1));
+            }
+        } else {
+            container.kind = Array;
+            container.values.reserve(count);
+            for (auto w = first; w < last; w++) {
+                for (auto word = words[w]; word; word &= word - 1)
+                    container.values.append(quint16((w - first) * 64 + std::countr_zero(word)));
+            }
+        }
+        containers.append(container);
+    }
+}
+
+RowBitmap RoaringBitmap::toRowBitmap() const
+{
+    return unpack(0);
+}
+
+void RoaringBitmap::insert(qsizetype position, const RowBitmap &other)
+{
+    if (other.size() == 0)
+        return;
+    const auto block = qMin(position / BlockBits, containers.count());
+    auto rows = unpack(block);
+    ones -= rows.count();
+    rows.insert(position - block * BlockBits, other);
+    pack(block, rows);
+}
+
+void RoaringBitmap::remove(qsizetype position, qsizetype count)
+{
+    if (count <= 0)
+        return;
+    const auto block = position / BlockBits;
+    auto rows = unpack(block);
+    ones -= rows.count();
+    rows.remove(position - block * BlockBits, count);
+    pack(block, rows);
+}
+
+RowBitmap RoaringBitmap::unpack(qsizetype first) const
+{
+    RowBitmap ret(qMax<qsizetype>(bits - first * BlockBits, 0));
+    const auto words = ret.data();
+    for (qsizetype i = first; i < containers.count(); i++) {
+        const auto &container = containers.at(i);
+        const auto block = words + (i - first) * BlockWords;
+        switch (container.kind) {
+        case Array:
+            for (const auto value : container.values)
+                block[value >> 6] |= quint64(1) << (value & 63);
+            break;
+        case Runs:
+            for (qsizetype r = 0; r < container.values.count(); r += 2) {
+                for (int row = container.values.at(r); row <= container.values.at(r + 1); row++)
+                    block[row >> 6] |= quint64(1) << (row & 63);
+            }
+            break;
+        case Bitmap:
+            std::copy(container.words.cbegin(), container.words.cend(), block);
+            break;
+        }
+    }
+    ret.update();
+    return ret;
+}
+
+qsizetype RoaringBitmap::bytes() const
+{
+    qsizetype ret = containers.count() * qsizetype(sizeof(Container));
+    for (const auto &container : containers)
+        ret += container.values.count() * 2 + container.words.count() * 8;
+    return ret;
+}
+
+void RoaringBitmap::pack(qsizetype block, const RowBitmap &rows)
+{
+    const RoaringBitmap packed(rows);
+    containers.resize(block);
+    containers.append(packed.containers);
+    bits = block * BlockBits + packed.bits;
+    ones += packed.ones;
+}
@@ -0,0 +1,59 @@
+#ifndef ROARINGBITMAP_H
+#define ROARINGBITMAP_H
+
+#include <QtCore/QList>
+
+class RowBitmap;
+
+// A RowBitmap compressed the way Roaring bitmaps are: the rows are cut into
+// blocks of 65536 and each block is kept as whichever is smallest of a sorted
+// list of the set rows, a list of runs of set rows, or the plain bits. Filter
+// results are mostly sparse or clustered, so kept ones take a fraction of the
+// memory of the RowBitmap they came from.
+class RoaringBitmap
+{
+public:
+    RoaringBitmap() = default;
+    explicit RoaringBitmap(const RowBitmap &bitmap);
+
+    RowBitmap toRowBitmap() const;
+
+    // as RowBitmap does; only the blocks from the one position is in on are
+    // unpacked and packed again, which is the last one for rows appended
+    void insert(qsizetype position, const RowBitmap &other);
+    void remove(qsizetype position, qsizetype count);
+
+    qsizetype size() const { return bits; }
+    qsizetype count() const { return ones; }
+    // memory taken by the blocks
+    qsizetype bytes() const;
+
+private:
+    enum Kind : quint8 {
+        Array,
+        Runs,
+        Bitmap,
+    };
+    struct Container
+    {
+        Kind kind;
+        // Array: the set rows, Runs: first and last row of each run, both
+        // relative to the block
+        QList<quint16> values;
+        // Bitmap: the words of the block
+        QList<quint64> words;
+    };
+
+    // the rows from block first on
+    RowBitmap unpack(qsizetype first) const;
+    // replaces the blocks from block on with rows, ones has to be without them
+    void pack(qsizetype block, const RowBitmap &rows);
+
+    static constexpr qsizetype BlockBits = 65536;
+    static constexpr qsizetype BlockWords = BlockBits / 64;
+    qsizetype bits = 0;
+    qsizetype ones = 0;
+    QList<Container> containers;
+};
+
+#endif // ROARINGBITMAP_H
@@ -0,0 +1,148 @@
+#include "rowbitmap.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+// count bits of source from bit from, 0 < count <= 64
+quint64 read(const QList<quint64> &source, qsizetype from, qsizetype count)
+{
+    const auto word = from >> 6;
+    const auto shift = from & 63;
+    quint64 ret = source.at(word) >> shift;
+    if (shift > 0 && shift + count > 64)
+        ret |= source.at(word + 1) << (64 - shift);
+    if (count < 64)
+        ret &= (quint64(1) << count) - 1;
+    return ret;
+}
+
+}
+
+RowBitmap::RowBitmap(qsizetype size)
+    : bits(size)
+    , words((size + 63) / 64, 0)
+{
+    update();
+}
+
+qsizetype RowBitmap::rank(qsizetype i) const
+{
+    const auto word = i >> 6;
+    const auto block = word / BlockWords;
+    if (block >= ranks.count())
+        return ones;
+    qsizetype ret = ranks.at(block);
+    for (auto w = block * BlockWords; w < word; w++)
+        ret += std::popcount(words.at(w));
+    if (i & 63)
+        ret += std::popcount(words.at(word) & ((quint64(1) << (i & 63)) - 1));
+    return ret;
+}
+
+qsizetype RowBitmap::select(qsizetype n) const
+{
+    // the last block that starts at or before set bit n holds it
+    const auto block = std::upper_bound(ranks.cbegin(), ranks.cend(), n) - ranks.cbegin() - 1;
+    auto remaining = n - ranks.at(block);
+    for (auto w = block * BlockWords; ; w++) {
+        auto word = words.at(w);
+        const qsizetype count = std::popcount(word);
+        if (remaining < count) {
+            for (; remaining > 0; remaining--)
+                word &= word - 1;
+            return w * 64 + std::countr_zero(word);
+        }
+        remaining -= count;
+    }
+}
+
+RowBitmap &RowBitmap::operator&=(const RowBitmap &other)
+{
+    for (qsizetype i = 0; i < words.count(); i++)
+        words[i] &= other.words.at(i);
+    update();
+    return *this;
+}
+
+void RowBitmap::insert(qsizetype position, const RowBitmap &other)
+{
+    if (other.bits == 0)
+        return;
+    // rows are mostly appended, which leaves the words before alone
+    if (position == bits) {
+        append(other.words, 0, other.bits);
+        update(position);
+        return;
+    }
+    const auto old = std::exchange(words, {});
+    const auto size = std::exchange(bits, 0);
+    const auto kept = position & ~qsizetype(63);
+    words.reserve((size + other.bits + 63) / 64);
+    words.append(old.first(kept / 64));
+    bits = kept;
+    append(old, kept, position - kept);
+    append(other.words, 0, other.bits);
+    append(old, position, size - position);
+    update(kept);
+}
+
+void RowBitmap::remove(qsizetype position, qsizetype count)
+{
+    if (count <= 0)
+        return;
+    const auto old = std::exchange(words, {});
+    const auto size = std::exchange(bits, 0);
+    const auto kept = position & ~qsizetype(63);
+    words.append(old.first(kept / 64));
+    bits = kept;
+    append(old, kept, position - kept);
+    append(old, position + count, size - position - count);
+    update(kept);
+}
+
+void RowBitmap::clear()
+{
+    bits = 0;
+    words.clear();
+    ranks.clear();
+    ones = 0;
+}
+
+void RowBitmap::update(qsizetype from)
+{
+    // the counts before the first changed block are still right
+    auto block = qMin(from / 64 / BlockWords, ranks.count());
+    qsizetype rank = 0;
+    if (block < ranks.count()) {
+        rank = ranks.at(block);
+    } else if (block > 0) {
+        rank = ranks.at(block - 1);
+        for (auto w = (block - 1) * BlockWords; w < block * BlockWords; w++)
+            rank += std::popcount(words.at(w));
+    }
+    const auto blocks = (words.count() + BlockWords - 1) / BlockWords;
+    ranks.resize(blocks);
+    for (; block < blocks; block++) {
+        ranks[block] = rank;
+        const auto end = qMin((block + 1) * BlockWords, words.count());
+        for (auto w = block * BlockWords; w < end; w++)
+            rank += std::popcount(words.at(w));
+    }
+    ones = rank;
+}
+
+void RowBitmap::append(const QList<quint64> &source, qsizetype from, qsizetype count)
+{
+    while (count > 0) {
+        const auto offset = bits & 63;
+        if (offset == 0)
+            words.append(0);
+        const auto n = qMin(count, 64 - offset);
+        words.last() |= read(source, from, n) << offset;
+        bits += n;
+        from += n;
+        count -= n;
+    }
+}
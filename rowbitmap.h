@@ -0,0 +1,55 @@
+#ifndef ROWBITMAP_H
+#define ROWBITMAP_H
+
+#include <QtCore/QList>
+
+// One bit per row of a model. A running count of the set bits before every
+// block of words makes rank() and select() cost a binary search and a few
+// popcounts instead of a scan, which is what a proxy needs to map rows both
+// ways.
+class RowBitmap
+{
+public:
+    RowBitmap() = default;
+    // size bits, all clear
+    explicit RowBitmap(qsizetype size);
+
+    qsizetype size() const { return bits; }
+    // set bits, as of the last update()
+    qsizetype count() const { return ones; }
+    bool testBit(qsizetype i) const { return words.at(i >> 6) >> (i & 63) & 1; }
+    void setBit(qsizetype i) { words[i >> 6] |= quint64(1) << (i & 63); }
+
+    // The words, for threads that fill disjoint word-aligned ranges. Call
+    // update() once they are done.
+    quint64 *data() { return words.data(); }
+    const quint64 *constData() const { return words.constData(); }
+
+    // set bits before i
+    qsizetype rank(qsizetype i) const;
+    // position of set bit n, counting from 0
+    qsizetype select(qsizetype n) const;
+
+    // keeps the bits set in both, other has the same size
+    RowBitmap &operator&=(const RowBitmap &other);
+
+    void insert(qsizetype position, const RowBitmap &other);
+    void remove(qsizetype position, qsizetype count);
+    void clear();
+
+    // counts the set bits again from bit from on
+    void update(qsizetype from = 0);
+
+private:
+    void append(const QList<quint64> &source, qsizetype from, qsizetype count);
+
+    static constexpr qsizetype BlockWords = 8;
+    qsizetype bits = 0;
+    // bits past size() are clear
+    QList<quint64> words;
+    // set bits before each block of BlockWords words
+    QList<qsizetype> ranks;
+    qsizetype ones = 0;
+};
+
+#endif // ROWBITMAP_H
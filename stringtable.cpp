@@ -0,0 +1,21 @@
+#include "stringtable.h"
+
+quint32 StringTable::insert(const QByteArray &value)
+{
+    const auto it = ids.constFind(QByteArrayView(value));
+    if (it != ids.constEnd())
+        return it.value();
+    const quint32 id = bytes.count();
+    // take a deep copy, value may point into a mapping
+    bytes.append(QByteArray(value.constData(), value.size()));
+    strings.append(QString::fromUtf8(bytes.last()));
+    ids.insert(QByteArrayView(bytes.last()), id);
+    return id;
+}
+
+void StringTable::clear()
+{
+    ids.clear();
+    strings.clear();
+    bytes.clear();
+}
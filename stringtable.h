@@ -0,0 +1,30 @@
+#ifndef STRINGTABLE_H
+#define STRINGTABLE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+// Interns the values of a low-cardinality column. Each distinct value gets a
+// dense id in order of appearance and is decoded from UTF-8 only once, so rows
+// store an id and readers share the QString.
+class StringTable
+{
+public:
+    quint32 insert(const QByteArray &value);
+
+    qsizetype count() const { return strings.count(); }
+    const QString &string(quint32 id) const { return strings.at(id); }
+    const QList<QByteArray> &values() const { return bytes; }
+
+    void clear();
+
+private:
+    QList<QByteArray> bytes;
+    QList<QString> strings;
+    // keys point into bytes, whose data never moves
+    QHash<QByteArrayView, quint32> ids;
+};
+
+#endif // STRINGTABLE_H
@@ -0,0 +1,187 @@
+#include "gstreamerlogtokenizer.h"
+#include "timestamp.h"
+
+#include <QtCore/QRandomGenerator>
+#include <QtTest/QTest>
+
+// The single pass scanner stands in for the regular expression the viewer
+// used before. Both are fed the same lines and have to agree on whether a
+// line splits and where every field starts and ends.
+class TestGStreamerLogTokenizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fields_data();
+    void fields();
+    void mutations_data();
+    void mutations();
+
+private:
+    static void addLines();
+    static void compare(const QByteArray &line);
+};
+
+void TestGStreamerLogTokenizer::addLines()
+{
+    QTest::addColumn<QByteArray>("line");
+    // whether the regular expression splits it
+    QTest::addColumn<bool>("splits");
+
+    QTest::newRow("typical")
+            << QByteArray("0:00:00.012345678 12345 0x55d5c8a0b200 DEBUG                GST_INIT gst.c:586:init_pre: Initializing GStreamer Core Library version 1.22.0")
+            << true;
+    QTest::newRow("object")
+            << QByteArray("0:00:01.000000000  4242 0x7f0000001234 WARN                 basesrc gstbasesrc.c:3132:gst_base_src_loop:<videotestsrc0> error: Internal data stream error.")
+            << true;
+    QTest::newRow("object with spaces before it")
+            << QByteArray("0:00:01.000000000 4242 0x7f0000001234 INFO GST_STATES gstbin.c:2928:gst_bin_change_state_func:   <pipeline0> child 'src' changed state")
+            << true;
+    QTest::newRow("short")
+            << QByteArray("1:02:03.4 1 0xa E c a.c:1:f: m")
+            << true;
+    QTest::newRow("tabs")
+            << QByteArray("0:00:00.1\t2\t0xab\tLOG\tcat\tfile.c:10:func:\tmessage")
+            << true;
+    QTest::newRow("empty category")
+            << QByteArray("0:00:00.1 2 0xab LOG  file.c:10:func: message")
+            << true;
+    QTest::newRow("empty source and function")
+            << QByteArray("0:00:00.1 2 0xab LOG cat :10:: message")
+            << true;
+    QTest::newRow("colons in message")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c:10:func:<obj> a: b: c: 1:2:3")
+            << true;
+    QTest::newRow("long message")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c:10:func: ") + QByteArray(300, 'x')
+            << true;
+
+    QTest::newRow("empty") << QByteArray() << false;
+    QTest::newRow("spaces") << QByteArray("     ") << false;
+    QTest::newRow("no message")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c:10:func:<obj>")
+            << false;
+    QTest::newRow("message of spaces")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c:10:func:<obj>   ")
+            << true;
+    QTest::newRow("upper case hex")
+            << QByteArray("0:00:00.1 2 0xAB LOG cat file.c:10:func: message")
+            << false;
+    QTest::newRow("lower case level")
+            << QByteArray("0:00:00.1 2 0xab log cat file.c:10:func: message")
+            << false;
+    QTest::newRow("no line number")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c::func: message")
+            << false;
+    QTest::newRow("upper case source")
+            << QByteArray("0:00:00.1 2 0xab LOG cat File.c:10:func: message")
+            << false;
+    QTest::newRow("missing colon")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c:10:func message")
+            << false;
+    QTest::newRow("not a log line") << QByteArray("Setting pipeline to PAUSED ...") << false;
+
+    // where the greedy path fails and the expression backtracks
+    QTest::newRow("space in category")
+            << QByteArray("0:00:00.1 2 0xab LOG cat egory file.c:10:func: message")
+            << false;
+    QTest::newRow("source after category with colons")
+            << QByteArray("0:00:00.1 2 0xab LOG a:b file.c:10:func: message")
+            << true;
+    QTest::newRow("colon in function")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c:10:a::b: message")
+            << true;
+    QTest::newRow("digits after line")
+            << QByteArray("0:00:00.1 2 0xab LOG cat file.c:10:20:func: message")
+            << true;
+}
+
+void TestGStreamerLogTokenizer::compare(const QByteArray &line)
+{
+    GStreamerLogTokenizer matched;
+    matched.text = line;
+    const bool splits = matched.match();
+
+    // the scanner may leave a line to the expression, but never split one
+    // differently
+    GStreamerLogTokenizer scanned;
+    scanned.text = line;
+    if (scanned.scan()) {
+        QVERIFY2(splits, line.constData());
+        for (int i = 0; i < GStreamerLogTokenizer::FieldCount; i++) {
+            QCOMPARE(scanned.begin[i], matched.begin[i]);
+            QCOMPARE(scanned.end[i], matched.end[i]);
+        }
+    }
+
+    GStreamerLogTokenizer tokenizer;
+    QCOMPARE(tokenizer.tokenize(line), splits);
+    if (!splits)
+        return;
+    for (int i = 0; i < GStreamerLogTokenizer::FieldCount; i++) {
+        QCOMPARE(tokenizer.begin[i], matched.begin[i]);
+        QCOMPARE(tokenizer.end[i], matched.end[i]);
+    }
+    QCOMPARE(tokenizer.timestamp, Timestamp::fromString(matched.field(0)).toNSecs());
+    QCOMPARE(tokenizer.pid, QByteArray(matched.field(1).toByteArray()).toInt());
+    QCOMPARE(tokenizer.line, QByteArray(matched.field(6).toByteArray()).toInt());
+}
+
+void TestGStreamerLogTokenizer::fields_data()
+{
+    addLines();
+}
+
+void TestGStreamerLogTokenizer::fields()
+{
+    QFETCH(QByteArray, line);
+    QFETCH(bool, splits);
+
+    GStreamerLogTokenizer matched;
+    matched.text = line;
+    QCOMPARE(matched.match(), splits);
+    compare(line);
+}
+
+void TestGStreamerLogTokenizer::mutations_data()
+{
+    addLines();
+}
+
+// Lines with a few bytes replaced, inserted or removed, which end up in every
+// corner of the scanner and across the blocks it compares at once.
+void TestGStreamerLogTokenizer::mutations()
+{
+    QFETCH(QByteArray, line);
+    static const QByteArray bytes(" \t\v:.0123456789abcfx_-<>AZ\xa0\xff");
+    QRandomGenerator random(quint32(qHash(line)));
+    for (int i = 0; i < 2000; i++) {
+        auto mutated = line;
+        const int count = random.bounded(1, 4);
+        for (int j = 0; j < count; j++) {
+            const auto position = mutated.isEmpty() ? 0 : random.bounded(int(mutated.size()));
+            const char byte = bytes.at(random.bounded(int(bytes.size())));
+            switch (random.bounded(3)) {
+            case 0:
+                if (position < mutated.size())
+                    mutated[position] = byte;
+                break;
+            case 1:
+                mutated.insert(position, byte);
+                break;
+            default:
+                mutated.remove(position, 1);
+                break;
+            }
+        }
+        compare(mutated);
+        if (QTest::currentTestFailed()) {
+            qWarning() << "line:" << mutated;
+            return;
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestGStreamerLogTokenizer)
+
+#include "tst_gstreamerlogtokenizer.moc"
@@ -0,0 +1,183 @@
+#include "timestamp.h"
+
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QTime>
+#include <QtTest/QTest>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// Timestamp as it was before it became a plain value: a heap allocated
+// QTime, nanoseconds and the text, copied on every copy.
+class HeapTimestamp
+{
+public:
+    HeapTimestamp() : d(new Private) {}
+    HeapTimestamp(const HeapTimestamp &other) : d(new Private(*other.d)) {}
+    HeapTimestamp &operator=(const HeapTimestamp &other)
+    {
+        *d = *other.d;
+        return *this;
+    }
+
+    static HeapTimestamp fromNSecs(qint64 nsecs)
+    {
+        HeapTimestamp ret;
+        ret.d->time = QTime(0, 0).addSecs(nsecs / 1000000000);
+        ret.d->nsecs = nsecs % 1000000000;
+        ret.d->string = Timestamp::fromNSecs(nsecs).toString();
+        return ret;
+    }
+
+    bool operator<(const HeapTimestamp &other) const
+    {
+        if (d->time != other.d->time)
+            return d->time < other.d->time;
+        return d->nsecs < other.d->nsecs;
+    }
+    bool operator==(const HeapTimestamp &other) const
+    {
+        return d->time == other.d->time && d->nsecs == other.d->nsecs;
+    }
+
+private:
+    struct Private
+    {
+        QTime time;
+        qint64 nsecs = 0;
+        QString string;
+    };
+    std::unique_ptr<Private> d;
+};
+
+// nanoseconds of a log an hour long, nearly in order like the rows of one
+QList<qint64> nsecs()
+{
+    constexpr qsizetype Count = 1000000;
+    QList<qint64> ret;
+    ret.reserve(Count);
+    auto random = QRandomGenerator(1);
+    for (qsizetype i = 0; i < Count; i++)
+        ret.append(i * 3600000 + random.bounded(10000000));
+    return ret;
+}
+
+template <typename T>
+QList<T> timestamps()
+{
+    QList<T> ret;
+    for (const auto value : nsecs())
+        ret.append(T::fromNSecs(value));
+    return ret;
+}
+
+template <typename T>
+void benchmarkCopy()
+{
+    const auto list = timestamps<T>();
+    QBENCHMARK {
+        QList<T> copied;
+        copied.reserve(list.count());
+        for (const auto &timestamp : list)
+            copied.append(timestamp);
+        QCOMPARE(copied.count(), list.count());
+    }
+}
+
+template <typename T>
+void benchmarkCompare()
+{
+    const auto list = timestamps<T>();
+    QBENCHMARK {
+        qsizetype ascending = 0;
+        for (qsizetype i = 1; i < list.count(); i++)
+            ascending += !(list.at(i) < list.at(i - 1)) && !(list.at(i) == list.at(i - 1));
+        QVERIFY(ascending > 0);
+    }
+}
+
+template <typename T>
+void benchmarkSort()
+{
+    const auto list = timestamps<T>();
+    QBENCHMARK {
+        auto sorted = list;
+        std::sort(sorted.begin(), sorted.end());
+        QVERIFY(std::is_sorted(sorted.cbegin(), sorted.cend()));
+    }
+}
+
+}
+
+// Copies, compares and sorts a million timestamps, the way the model and the
+// timeline handle them, as values and as they were before.
+class TestTimestamp : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void copy_data();
+    void copy();
+    void compare_data();
+    void compare();
+    void sort_data();
+    void sort();
+
+private:
+    static void addKinds();
+};
+
+void TestTimestamp::addKinds()
+{
+    QTest::addColumn<bool>("value");
+    QTest::newRow("value") << true;
+    QTest::newRow("heap") << false;
+}
+
+void TestTimestamp::copy_data()
+{
+    addKinds();
+}
+
+void TestTimestamp::copy()
+{
+    QFETCH(bool, value);
+    if (value)
+        benchmarkCopy<Timestamp>();
+    else
+        benchmarkCopy<HeapTimestamp>();
+}
+
+void TestTimestamp::compare_data()
+{
+    addKinds();
+}
+
+void TestTimestamp::compare()
+{
+    QFETCH(bool, value);
+    if (value)
+        benchmarkCompare<Timestamp>();
+    else
+        benchmarkCompare<HeapTimestamp>();
+}
+
+void TestTimestamp::sort_data()
+{
+    addKinds();
+}
+
+void TestTimestamp::sort()
+{
+    QFETCH(bool, value);
+    if (value)
+        benchmarkSort<Timestamp>();
+    else
+        benchmarkSort<HeapTimestamp>();
+}
+
+QTEST_APPLESS_MAIN(TestTimestamp)
+
+#include "tst_timestamp.moc"
@@ -3,35 +3,57 @@
 
 #include <QtCore/QMetaType>
 #include <QtCore/QString>
-#include <QtCore/QScopedPointer>
 
+#include <compare>
+#include <type_traits>
+
+// A point in time of a GStreamer log, nanoseconds since the pipeline started.
+// It is a plain 64-bit value; the H:MM:SS.NNNNNNNNN text is only produced by
+// toString().
 class Timestamp
 {
 public:
     static int metaTypeId;
-    Timestamp();
-    Timestamp(const Timestamp &other);
-    ~Timestamp();
+    constexpr Timestamp() = default;
+
+    static constexpr Timestamp fromNSecs(qint64 nsecs)
+    {
+        Timestamp ret;
+        ret.nsecs = nsecs;
+        return ret;
+    }
+    constexpr qint64 toNSecs() const { return nsecs; }
 
+    static Timestamp fromString(QByteArrayView text);
     static Timestamp fromString(const QString &text);
     QString toString() const;
 
-    static Timestamp mix(const Timestamp &a, const Timestamp &b, qreal t);
+    static constexpr Timestamp mix(Timestamp a, Timestamp b, qreal t)
+    {
+        return fromNSecs(a.nsecs + qint64((b.nsecs - a.nsecs) * t));
+    }
 
-    Timestamp &operator=(const Timestamp &other);
-    int operator<=>(const Timestamp &other) const;
-    bool operator==(const Timestamp &other) const;
+    constexpr auto operator<=>(const Timestamp &other) const = default;
+    constexpr bool operator==(const Timestamp &other) const = default;
 
-    qint64 secsTo(const Timestamp &other) const;
-    qint64 msecsTo(const Timestamp &other) const;
-    qint64 usecsTo(const Timestamp &other) const;
-    qint64 nsecsTo(const Timestamp &other) const;
+    constexpr Timestamp &operator+=(qint64 nsecs) { this->nsecs += nsecs; return *this; }
+    constexpr Timestamp &operator-=(qint64 nsecs) { this->nsecs -= nsecs; return *this; }
+    friend constexpr Timestamp operator+(Timestamp timestamp, qint64 nsecs) { return timestamp += nsecs; }
+    friend constexpr Timestamp operator-(Timestamp timestamp, qint64 nsecs) { return timestamp -= nsecs; }
+    friend constexpr qint64 operator-(Timestamp a, Timestamp b) { return a.nsecs - b.nsecs; }
+
+    constexpr qint64 secsTo(Timestamp other) const { return (other.nsecs - nsecs) / 1000000000; }
+    constexpr qint64 msecsTo(Timestamp other) const { return (other.nsecs - nsecs) / 1000000; }
+    constexpr qint64 usecsTo(Timestamp other) const { return (other.nsecs - nsecs) / 1000; }
+    constexpr qint64 nsecsTo(Timestamp other) const { return other.nsecs - nsecs; }
 
 private:
-    class Private;
-    QScopedPointer<Private> d;
+    qint64 nsecs = 0;
 };
 
+static_assert(std::is_trivially_copyable_v<Timestamp>);
+static_assert(sizeof(Timestamp) == sizeof(qint64));
+
 Q_DECLARE_METATYPE(Timestamp)
 
 #endif // TIMESTAMP_H
@@ -1,34 +1,149 @@
 #include "timestampview.h"
+#include "customfilterproxymodel.h"
 #include "gstreamerlogmodel.h"
 #include "timestamp.h"
 
-#include <QtCore/QTime>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QFuture>
 
 #include <QtGui/QMouseEvent>
 #include <QtGui/QPainter>
+#include <QtGui/QWheelEvent>
 
 #include <QtWidgets/QHeaderView>
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QScrollBar>
 
+#include <algorithm>
+#include <cmath>
+
 namespace {
+    // rows per pixel row of the timeline, and what they were counted for
     struct Cache {
-        QImage timeline;
-        int rowCount = 0;
+        QList<qsizetype> counts;
+        int height = 0;
+        int headerHeight = 0;
+        Timestamp min;
+        Timestamp max;
+        bool valid = false;
+    };
+
+    // hits per pixel row of the strip, and what they were counted for
+    struct Density {
+        QList<int> counts;
+        int peak = 0;
+        int height = 0;
+        int headerHeight = 0;
+        Timestamp min;
+        Timestamp max;
+        quint64 generation = 0;
+        bool pending = false;
     };
+
+    constexpr int StripWidth = 6;
+    // how far the timeline zooms in, in nanoseconds
+    constexpr qint64 MinimumSpan = 1000;
 }
 
 class TimestampView::Private
 {
+public:
+    Private(TimestampView *parent);
+    Timestamp timestamp(int row) const;
+    // the time the timeline shows from top to bottom, that of all rows
+    // unless zoomed in, false if there are none
+    bool span(Timestamp *min, Timestamp *max) const;
+    // the time at y of the timeline
+    Timestamp at(qreal y) const;
+    void count(int h, int headerHeight, Timestamp min, Timestamp max);
+
+private:
+    TimestampView *q;
 public:
     QTableView *buddy = nullptr;
     QLabel *label;
     Cache cache;
+    bool zoomed = false;
+    Timestamp zoomMin;
+    Timestamp zoomMax;
+    QList<int> hits;
+    QList<Timestamp> hitTimestamps;
+    // changes with the hits, a density of another one is counted again
+    quint64 generation = 0;
+    Density density;
 };
 
+TimestampView::Private::Private(TimestampView *parent)
+    : q(parent)
+{}
+
+Timestamp TimestampView::Private::timestamp(int row) const
+{
+    return buddy->model()->index(row, GStreamerLogModel::TimestampColumn).data(GStreamerLogModel::TimestampRole).value<Timestamp>();
+}
+
+bool TimestampView::Private::span(Timestamp *min, Timestamp *max) const
+{
+    const auto count = buddy ? buddy->model()->rowCount() : 0;
+    if (count < 1)
+        return false;
+    if (zoomed) {
+        *min = zoomMin;
+        *max = zoomMax;
+    } else {
+        *min = timestamp(0);
+        *max = timestamp(count - 1);
+    }
+    return true;
+}
+
+Timestamp TimestampView::Private::at(qreal y) const
+{
+    Timestamp min;
+    Timestamp max;
+    if (!span(&min, &max))
+        return Timestamp();
+    const auto headerHeight = buddy->horizontalHeader()->height();
+    const auto h = q->height();
+    y = qBound<qreal>(headerHeight, y, h);
+    return Timestamp::mix(min, max, (y - headerHeight) / qMax(h - headerHeight, 1));
+}
+
+// Counts the hits per pixel row on the thread pool, in one pass over their
+// timestamps, and repaints once they are counted.
+void TimestampView::Private::count(int h, int headerHeight, Timestamp min, Timestamp max)
+{
+    density.pending = true;
+    QtConcurrent::run([timestamps = hitTimestamps, h, headerHeight, min, max]() {
+        // a view too short to have a timeline counts nothing
+        if (h <= headerHeight)
+            return QList<int>();
+        QList<int> counts(h, 0);
+        const qreal range = qMax<qint64>(min.nsecsTo(max), 1);
+        for (const auto &timestamp : timestamps) {
+            // zoomed in, the hits outside are not marked
+            if (timestamp < min || max < timestamp)
+                continue;
+            const int y = min.nsecsTo(timestamp) / range * (h - headerHeight) + headerHeight;
+            counts[qBound(headerHeight, y, h - 1)]++;
+        }
+        return counts;
+    }).then(q, [this, run = generation, h, headerHeight, min, max](const QList<int> &counts) {
+        density.counts = counts;
+        density.peak = counts.isEmpty() ? 0 : *std::max_element(counts.cbegin(), counts.cend());
+        density.height = h;
+        density.headerHeight = headerHeight;
+        density.min = min;
+        density.max = max;
+        density.generation = run;
+        density.pending = false;
+        q->update();
+    });
+}
+
 TimestampView::TimestampView(QWidget *parent)
     : QWidget{parent}
-    , d(new Private)
+    , d(new Private(this))
 {
     d->label = new QLabel(this);
     setMouseTracking(true);
@@ -38,7 +153,18 @@ TimestampView::TimestampView(QWidget *parent)
             connect(scrollBar, &QScrollBar::valueChanged, this, qOverload<>(&TimestampView::update));
             const auto model = buddy->model();
             if (model) {
-                connect(model, &QAbstractItemModel::layoutChanged, this, qOverload<>(&TimestampView::update));
+                // counting the rows again is a binary search per pixel row
+                auto invalidate = [this]() {
+                    d->cache.valid = false;
+                    update();
+                };
+                connect(model, &QAbstractItemModel::rowsInserted, this, invalidate);
+                connect(model, &QAbstractItemModel::layoutChanged, this, invalidate);
+                connect(model, &QAbstractItemModel::rowsRemoved, this, invalidate);
+                connect(model, &QAbstractItemModel::modelReset, this, [this, invalidate]() {
+                    d->zoomed = false;
+                    invalidate();
+                });
             } else {
                 qFatal("model must be set before setBuddy");
             }
@@ -60,18 +186,34 @@ void TimestampView::setBuddy(QTableView *buddy)
     emit buddyChanged(buddy);
 }
 
+void TimestampView::setHits(const QList<int> &rows, const QList<Timestamp> &timestamps)
+{
+    d->hits = rows;
+    d->hitTimestamps = timestamps;
+    d->generation++;
+    d->density.counts.clear();
+    update();
+}
+
 void TimestampView::mousePressEvent(QMouseEvent *event)
 {
-    const auto headerHeight = d->buddy->horizontalHeader()->height();
-    const auto h = height();
-    const auto y = qBound<qreal>(headerHeight, event->position().y(), h);
-    const auto count = d->buddy->model()->rowCount();
-    QModelIndex minIndex = d->buddy->model()->index(0, GStreamerLogModel::TimestampColumn);
-    QModelIndex maxIndex = d->buddy->model()->index(count - 1, GStreamerLogModel::TimestampColumn);
-    const auto minTimestamp = Timestamp::fromString(minIndex.data().toString());
-    const auto maxTimestamp = Timestamp::fromString(maxIndex.data().toString());
-    const auto mix = Timestamp::mix(minTimestamp, maxTimestamp, (qreal)(y - headerHeight) / (h - headerHeight));
-    const auto indices = d->buddy->model()->match(minIndex, Qt::DisplayRole, QVariant::fromValue(mix), 1, Qt::MatchStartsWith); // abuse the flag for nearest timestamp match
+    const auto model = d->buddy->model();
+    if (model->rowCount() < 1)
+        return;
+    const auto mix = d->at(event->position().y());
+    // on the strip, the hit nearest in time
+    if (event->position().x() < StripWidth && !d->hits.isEmpty()) {
+        const auto &timestamps = d->hitTimestamps;
+        auto i = std::lower_bound(timestamps.cbegin(), timestamps.cend(), mix) - timestamps.cbegin();
+        if (i == timestamps.count() || (i > 0 && timestamps.at(i - 1).nsecsTo(mix) < mix.nsecsTo(timestamps.at(i))))
+            i--;
+        const auto current = d->buddy->currentIndex();
+        const auto index = model->index(d->hits.at(i), current.isValid() ? current.column() : GStreamerLogModel::TimestampColumn);
+        d->buddy->setCurrentIndex(index);
+        d->buddy->scrollTo(index, QAbstractItemView::PositionAtCenter);
+        return;
+    }
+    const auto indices = model->match(model->index(0, GStreamerLogModel::TimestampColumn), Qt::DisplayRole, QVariant::fromValue(mix), 1, Qt::MatchStartsWith); // abuse the flag for nearest timestamp match
     if (!indices.isEmpty()) {
         const auto index = indices.first();
         d->buddy->scrollTo(index, QAbstractItemView::PositionAtCenter);
@@ -80,19 +222,9 @@ void TimestampView::mousePressEvent(QMouseEvent *event)
 
 void TimestampView::mouseMoveEvent(QMouseEvent *event)
 {
-    const auto headerHeight = d->buddy->horizontalHeader()->height();
-    const auto h = height();
-    const auto y = qBound<qreal>(headerHeight, event->position().y(), h);
-    const auto count = d->buddy->model()->rowCount();
     QString text;
-    const QModelIndex minIndex = d->buddy->model()->index(0, GStreamerLogModel::TimestampColumn);
-    const QModelIndex maxIndex = d->buddy->model()->index(count - 1, GStreamerLogModel::TimestampColumn);
-    if (minIndex.isValid() && maxIndex.isValid()) {
-        const auto minTimestamp = Timestamp::fromString(minIndex.data().toString());
-        const auto maxTimestamp = Timestamp::fromString(maxIndex.data().toString());
-        const auto mix = Timestamp::mix(minTimestamp, maxTimestamp, (qreal)(y - headerHeight) / (h - headerHeight));
-        text = mix.toString();
-    }
+    if (d->buddy->model()->rowCount() > 0)
+        text = d->at(event->position().y()).toString();
     d->label->setText(text);
     if (event->buttons() & Qt::LeftButton) {
         mousePressEvent(event);
@@ -112,37 +244,24 @@ void TimestampView::paintEvent(QPaintEvent *event)
     const int h = height();
 
     auto index2timestamp = [&](int row) -> Timestamp {
-        const auto data = model->index(row, GStreamerLogModel::TimestampColumn).data().toString();
-        static QHash<QString, Timestamp> cache;
-        if (cache.contains(data))
-            return cache.value(data);
-        const auto timestamp = Timestamp::fromString(data);
-        cache.insert(data, timestamp);
-        return timestamp;
+        return d->timestamp(row);
     };
 
-    const auto timestampMin = index2timestamp(0);
-    const auto timestampMax = index2timestamp(count - 1);
-    const qreal range = timestampMin.usecsTo(timestampMax);
-
-    if (d->cache.timeline.size() != QSize(w, h) || d->cache.rowCount != count) {
-        d->cache.timeline = QImage(QSize(w, h), QImage::Format_ARGB32_Premultiplied);
-        d->cache.timeline.fill(Qt::transparent);
-        d->cache.rowCount = count;
-        QPainter painter(&d->cache.timeline);
-        painter.setRenderHint(QPainter::Antialiasing);
-
-        QPen pen(QColor(255, 0, 0, 10));
-        pen.setWidthF(0.5);
-        painter.setPen(pen);
-
-        QPolygonF lines;
-        for (int i = 0; i < count; i++) {
-            const auto timestamp = index2timestamp(i);
-            const qreal y = timestampMin.usecsTo(timestamp) / range * (h - headerHeight) + headerHeight;
-            lines << QPointF(0, y) << QPointF(w, y);
-        }
-        painter.drawLines(lines);
+    Timestamp timestampMin;
+    Timestamp timestampMax;
+    d->span(&timestampMin, &timestampMax);
+    const qreal range = qMax<qint64>(timestampMin.nsecsTo(timestampMax), 1);
+
+    auto &cache = d->cache;
+    if (!cache.valid || cache.height != h || cache.headerHeight != headerHeight
+            || cache.min != timestampMin || cache.max != timestampMax) {
+        const auto proxyModel = qobject_cast<CustomFilterProxyModel *>(model);
+        cache.counts = proxyModel ? proxyModel->histogram(timestampMin, timestampMax, h - headerHeight) : QList<qsizetype>();
+        cache.height = h;
+        cache.headerHeight = headerHeight;
+        cache.min = timestampMin;
+        cache.max = timestampMax;
+        cache.valid = true;
     }
 
     QPainter painter(this);
@@ -162,7 +281,28 @@ void TimestampView::paintEvent(QPaintEvent *event)
     }());
     painter.setBrush(brush);
 
-    painter.drawImage(0, 0, d->cache.timeline);
+    // as dark as count overlapping lines of alpha 10 each
+    for (int y = 0; y < cache.counts.count(); y++) {
+        const auto count = cache.counts.at(y);
+        if (count > 0)
+            painter.fillRect(0, y + headerHeight, w, 1, QColor(255, 0, 0, qRound(255 * (1 - std::pow(1 - 10 / 255.0, count)))));
+    }
+
+    if (!d->hits.isEmpty()) {
+        auto &density = d->density;
+        if ((density.generation != d->generation || density.height != h || density.headerHeight != headerHeight
+                || density.min != timestampMin || density.max != timestampMax) && !density.pending)
+            d->count(h, headerHeight, timestampMin, timestampMax);
+        // what was counted last, until the new counts are in
+        painter.save();
+        painter.setOpacity(1.0);
+        for (int y = 0; y < density.counts.count(); y++) {
+            const auto count = density.counts.at(y);
+            if (count > 0)
+                painter.fillRect(0, y, StripWidth, 1, QColor(255, 140, 0, 64 + 191 * count / density.peak));
+        }
+        painter.restore();
+    }
 
     const auto firstIndex = d->buddy->indexAt(QPoint(0, 0));
     auto firstRow = firstIndex.row();
@@ -174,9 +314,9 @@ void TimestampView::paintEvent(QPaintEvent *event)
         lastRow = count - 1;
     const auto firstTimestamp = index2timestamp(firstRow);
     const auto lastTimestamp = index2timestamp(lastRow);
-    const qreal range2 = qMax(firstTimestamp.usecsTo(lastTimestamp), 1);
-    const qreal yFirst = timestampMin.usecsTo(firstTimestamp) / range * (h - headerHeight) + headerHeight;
-    const qreal yLast = timestampMin.usecsTo(lastTimestamp) / range * (h - headerHeight) + headerHeight;
+    const qreal range2 = qMax<qint64>(firstTimestamp.nsecsTo(lastTimestamp), 1);
+    const qreal yFirst = timestampMin.nsecsTo(firstTimestamp) / range * (h - headerHeight) + headerHeight;
+    const qreal yLast = timestampMin.nsecsTo(lastTimestamp) / range * (h - headerHeight) + headerHeight;
 
     QPolygonF polygon = { QPointF(w, yFirst), QPointF(w * 2, headerHeight), QPointF(w * 2, h), QPointF(w, yLast) };
     painter.drawPolygon(polygon);
@@ -185,7 +325,7 @@ void TimestampView::paintEvent(QPaintEvent *event)
     for (int row = firstRow; row <= lastRow; row++) {
         const auto rect = d->buddy->visualRect(firstIndex.siblingAtRow(row));
         const auto timestamp = index2timestamp(row);
-        const qreal y = firstTimestamp.usecsTo(timestamp) / range2 * (h - headerHeight);
+        const qreal y = firstTimestamp.nsecsTo(timestamp) / range2 * (h - headerHeight);
         QPolygonF polygon = {
             QPointF(w * 2, y + headerHeight),
             QPointF(w * 3, rect.top() + 5 + headerHeight),
@@ -195,6 +335,45 @@ void TimestampView::paintEvent(QPaintEvent *event)
     }
 }
 
+// Zooms the timeline in and out around the time under the mouse, down to
+// MinimumSpan and up to all rows.
+void TimestampView::wheelEvent(QWheelEvent *event)
+{
+    const auto model = d->buddy ? d->buddy->model() : nullptr;
+    if (!model || model->rowCount() < 2 || event->angleDelta().y() == 0) {
+        // nothing to zoom, the parent may scroll instead
+        event->ignore();
+        return;
+    }
+    const auto headerHeight = d->buddy->horizontalHeader()->height();
+    const auto y = qBound<qreal>(headerHeight, event->position().y(), height());
+    const auto t = (y - headerHeight) / qMax(height() - headerHeight, 1);
+    const auto first = d->timestamp(0);
+    const auto last = d->timestamp(model->rowCount() - 1);
+    Timestamp min;
+    Timestamp max;
+    d->span(&min, &max);
+
+    const auto center = Timestamp::mix(min, max, t);
+    const auto span = qMax<qint64>(min.nsecsTo(max) * (event->angleDelta().y() > 0 ? 0.5 : 2.0), MinimumSpan);
+    if (span >= first.nsecsTo(last)) {
+        d->zoomed = false;
+    } else {
+        // keep the time under the mouse where it is, within the rows
+        min = center - qint64(span * t);
+        if (min < first)
+            min = first;
+        if (last < min + span)
+            min = last - span;
+        d->zoomMin = min;
+        d->zoomMax = min + span;
+        d->zoomed = true;
+    }
+    d->label->setText(center.toString());
+    event->accept();
+    update();
+}
+
 void TimestampView::resizeEvent(QResizeEvent *event)
 {
     QWidget::resizeEvent(event);
@@ -1,6 +1,8 @@
 #ifndef TIMESTAMPVIEW_H
 #define TIMESTAMPVIEW_H
 
+#include "timestamp.h"
+
 #include <QtWidgets/QWidget>
 #include <QtWidgets/QTableView>
 
@@ -16,6 +18,9 @@ public:
 
 public slots:
     void setBuddy(QTableView *buddy);
+    // Rows of the buddy to mark next to the timeline, ascending, and their
+    // timestamps. Clicking a mark goes to the nearest of them.
+    void setHits(const QList<int> &rows, const QList<Timestamp> &timestamps);
 
 signals:
     void buddyChanged(QTableView *buddy);
@@ -24,6 +29,7 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
 
 private:
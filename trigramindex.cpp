@@ -0,0 +1,145 @@
+#include "trigramindex.h"
+#include "rowbitmap.h"
+
+#include <algorithm>
+
+namespace {
+
+inline quint32 fold(char c)
+{
+    return uchar(c) - uchar('A') < 26u ? uchar(c | 0x20) : uchar(c);
+}
+
+void appendVarint(QByteArray *bytes, quint32 value)
+{
+    for (; value >= 0x80; value >>= 7)
+        bytes->append(char(value | 0x80));
+    bytes->append(char(value));
+}
+
+quint32 readVarint(const char *&p)
+{
+    quint32 ret = 0;
+    for (int shift = 0; ; shift += 7) {
+        const uchar byte = *p++;
+        ret |= quint32(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return ret;
+    }
+}
+
+// the rarest lists narrow the rows down the most, the others are left to
+// matching the rows that remain
+constexpr int MaxLists = 4;
+// memory a list takes besides its entries, hash node included
+constexpr qsizetype ListBytes = 64;
+
+}
+
+TrigramIndex::TrigramIndex(qsizetype from)
+    : first(from)
+    , rows(from)
+{}
+
+void TrigramIndex::add(QByteArrayView text)
+{
+    const quint32 row = rows++;
+    if (text.size() < 3)
+        return;
+    quint32 key = fold(text.at(0)) << 8 | fold(text.at(1));
+    for (qsizetype i = 2; i < text.size(); i++) {
+        key = (key << 8 | fold(text.at(i))) & 0xffffff;
+        auto &list = lists[key];
+        if (list.count > 0 && list.last == row)
+            continue;
+        const auto size = list.deltas.size();
+        appendVarint(&list.deltas, list.count > 0 ? row - list.last : row);
+        used += list.deltas.size() - size + (list.count > 0 ? 0 : ListBytes);
+        list.last = row;
+        list.count++;
+    }
+}
+
+void TrigramIndex::append(TrigramIndex &&other)
+{
+    Q_ASSERT(other.first == rows);
+    for (auto it = other.lists.begin(); it != other.lists.end(); ++it) {
+        auto &list = lists[it.key()];
+        auto &tail = it.value();
+        if (list.count == 0) {
+            list = std::move(tail);
+            used += list.deltas.size() + ListBytes;
+            continue;
+        }
+        // the first row of the tail becomes a distance from the last one here
+        const char *p = tail.deltas.constData();
+        const auto row = readVarint(p);
+        const auto size = list.deltas.size();
+        appendVarint(&list.deltas, row - list.last);
+        list.deltas.append(p, tail.deltas.constData() + tail.deltas.size() - p);
+        used += list.deltas.size() - size;
+        list.last = tail.last;
+        list.count += tail.count;
+    }
+    rows = other.rows;
+    limited = limited || other.limited;
+    other.clear();
+}
+
+void TrigramIndex::clear()
+{
+    rows = first;
+    used = 0;
+    limited = false;
+    lists.clear();
+}
+
+void TrigramIndex::candidates(QByteArrayView folded, RowBitmap *candidates) const
+{
+    const auto count = candidates->size();
+    for (auto row = rows; row < count; row++)
+        candidates->setBit(row);
+
+    QList<const List *> found;
+    quint32 key = fold(folded.at(0)) << 8 | fold(folded.at(1));
+    for (qsizetype i = 2; i < folded.size(); i++) {
+        key = (key << 8 | fold(folded.at(i))) & 0xffffff;
+        const auto it = lists.constFind(key);
+        // no indexed row has it
+        if (it == lists.cend())
+            return;
+        found.append(&it.value());
+    }
+    std::sort(found.begin(), found.end(), [](const List *a, const List *b) {
+        return a->count < b->count || (a->count == b->count && a < b);
+    });
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    if (found.count() > MaxLists)
+        found.resize(MaxLists);
+
+    auto decode = [](const List *list, auto function) {
+        const char *p = list->deltas.constData();
+        quint32 row = 0;
+        for (quint32 i = 0; i < list->count; i++) {
+            row += readVarint(p);
+            function(row);
+        }
+    };
+    // the rows of the rarest list that are in all of the others
+    QList<quint32> rarest;
+    rarest.reserve(found.first()->count);
+    decode(found.first(), [&](quint32 row) {
+        rarest.append(row);
+    });
+    for (qsizetype i = 1; i < found.count() && !rarest.isEmpty(); i++) {
+        RowBitmap other(rows);
+        decode(found.at(i), [&](quint32 row) {
+            other.setBit(row);
+        });
+        rarest.removeIf([&](quint32 row) {
+            return !other.testBit(row);
+        });
+    }
+    for (const auto row : std::as_const(rarest))
+        candidates->setBit(row);
+}
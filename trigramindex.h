@@ -0,0 +1,56 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+
+class RowBitmap;
+
+// The rows having each run of three bytes in their text, with ASCII folded
+// to lower case. A row can only contain a keyword when it has every trigram
+// of it, so intersecting a few of their lists leaves a handful of rows to
+// match instead of all of them. Lists are kept as varint deltas between
+// ascending rows, a byte or two per entry.
+class TrigramIndex
+{
+public:
+    // an index whose first row is from, for a range built on its own
+    explicit TrigramIndex(qsizetype from = 0);
+
+    // rows before size() are indexed
+    qsizetype size() const { return rows; }
+    // memory taken by the lists, roughly
+    qsizetype bytes() const { return used; }
+    // whether rows were left out to stay within a budget, see limit()
+    bool isLimited() const { return limited; }
+
+    // indexes text as row size()
+    void add(QByteArrayView text);
+    // takes the rows of other, which starts at size()
+    void append(TrigramIndex &&other);
+    // no more rows are to be added
+    void limit() { limited = true; }
+    void clear();
+
+    // Sets the rows of candidates that may contain folded, which is in lower
+    // case and at least three bytes: the indexed ones having its rarest
+    // trigrams and every row after size().
+    void candidates(QByteArrayView folded, RowBitmap *candidates) const;
+
+private:
+    struct List
+    {
+        // the first row, then the distance from each row to the next
+        QByteArray deltas;
+        quint32 last = 0;
+        quint32 count = 0;
+    };
+
+    qsizetype first = 0;
+    qsizetype rows = 0;
+    qsizetype used = 0;
+    bool limited = false;
+    QHash<quint32, List> lists;
+};
+
+#endif // TRIGRAMINDEX_H